@@ -23,6 +23,7 @@
 #include <assert.h>
 #include <stdio.h>
 #include <string.h>
+#include "common/endian.h"
 #include "common/file.h"
 #include "common/path.h"
 #include "common/array.h"
@@ -41,7 +42,7 @@ using Common::MemoryReadStream;
 
 namespace Kom {
 
-ActorManager::ActorManager(KomEngine *vm) : _vm(vm) {
+ActorManager::ActorManager(KomEngine *vm) : _vm(vm), _drawListValid(false) {
 	_actors.resize(6);
 	for (uint i = 0; i < _actors.size(); ++i)
 		_actors[i] = NULL;
@@ -66,10 +67,12 @@ int ActorManager::load(const Path &filename) {
 	for (uint i = 0; i < _actors.size(); ++i)
 		if (_actors[i] == NULL) {
 			_actors[i] = act;
+			_drawListValid = false;
 			return i;
 		}
 
 	_actors.push_back(act);
+	_drawListValid = false;
 	return _actors.size() - 1;
 }
 
@@ -89,6 +92,7 @@ void ActorManager::loadExtras() {
 	_mouseActor->setScope(0, 2);
 	_mouseActor->setPos(0, 0);
 	_mouseActor->setEffect(4);
+	_mouseActor->cacheCursors();
 
 	// Init CursorMan
 	_mouseActor->display();
@@ -164,23 +168,10 @@ void ActorManager::loadExtras() {
 }
 
 void ActorManager::displayAll() {
-	Actor *act;
-
-	for (uint i = 0; i < _actors.size(); ++i) {
-		act = getFarthestActor();
-		if (act == NULL)
-			break;
-
-		act->display();
-		act->_isActive = 99; // == "displayed"
-	}
+	const Common::Array<Actor *> &drawList = getDrawList();
 
-	for (uint i = 0; i < _actors.size(); ++i) {
-		act = _actors[i];
-		if (act != NULL && act->_isActive == 99) {
-			act->_isActive = 1;
-		}
-	}
+	for (uint i = 0; i < drawList.size(); ++i)
+		drawList[i]->display();
 }
 
 void ActorManager::pauseAnimAll(bool pause) {
@@ -204,20 +195,30 @@ void ActorManager::pauseAnimAll(bool pause) {
 	}
 }
 
-Actor *ActorManager::getFarthestActor() {
-	Common::Array<Actor *>::iterator act;
-	int maxDepth = 0;
-	Actor *maxActor = NULL;
+const Common::Array<Actor *> &ActorManager::getDrawList() {
+	if (_drawListValid)
+		return _drawList;
 
-	for (act = _actors.begin(); act != _actors.end(); act++) {
-		if (*act != NULL && (*act)->_isActive == 1)
-			if ((*act)->_depth > maxDepth) {
-				maxDepth = (*act)->_depth;
-				maxActor = *act;
-			}
+	_drawList.clear();
+
+	// Insert in array order, so that actors of equal depth keep it
+	for (uint i = 0; i < _actors.size(); ++i) {
+		Actor *act = _actors[i];
+
+		if (act == NULL || act->_isActive != 1 || act->_depth <= 0)
+			continue;
+
+		uint pos = _drawList.size();
+		_drawList.push_back(act);
+		while (pos > 0 && _drawList[pos - 1]->_depth < act->_depth) {
+			_drawList[pos] = _drawList[pos - 1];
+			pos--;
+		}
+		_drawList[pos] = act;
 	}
 
-	return maxActor;
+	_drawListValid = true;
+	return _drawList;
 }
 
 Actor::Actor(KomEngine *vm, const Path &filename, bool isMouse) : _vm(vm) {
@@ -255,9 +256,115 @@ Actor::Actor(KomEngine *vm, const Path &filename, bool isMouse) : _vm(vm) {
 }
 
 Actor::~Actor() {
+	for (uint i = 0; i < _frames.size(); ++i) {
+		if (_frames[i])
+			_vm->screen()->purgeScaledFrames(_frames[i]);
+		delete _frames[i];
+	}
 	delete[] _framesData;
 }
 
+static void decodeFrameLine(byte *outBuffer, const int8 *rowData, uint16 length) {
+	uint8 dataIndex = 0;
+	uint8 outIndex = 0;
+
+	while (outIndex < length) {
+		int8 imageData = rowData[dataIndex++];
+		if (imageData > 0)
+			while (imageData-- > 0)
+				outBuffer[outIndex++] = 0;
+		else if ((imageData &= 0x7F) > 0)
+			while (imageData-- > 0)
+				outBuffer[outIndex++] = rowData[dataIndex++];
+	}
+}
+
+const ActorFrame *Actor::getFrame(int16 frame) {
+	if ((uint16)frame >= _frames.size()) {
+		uint oldSize = _frames.size();
+		_frames.resize(frame + 1);
+		for (uint i = oldSize; i < _frames.size(); ++i)
+			_frames[i] = NULL;
+	}
+
+	if (_frames[frame])
+		return _frames[frame];
+
+	ActorFrame *f = new ActorFrame();
+	_frames[frame] = f;
+
+	MemoryReadStream frameStream(_framesData, _framesDataSize);
+
+	frameStream.seek(frame * 4);
+	int32 offset = frameStream.readSint32LE() - 10;
+
+	frameStream.seek(offset);
+	f->width = frameStream.readSint16LE();
+	f->height = frameStream.readSint16LE();
+	f->xOffset = frameStream.readSint16LE();
+	f->yOffset = frameStream.readSint16LE();
+
+	if (f->width <= 0 || f->height <= 0)
+		return f;
+
+	const int8 *data = (const int8 *)(_framesData + frameStream.pos());
+
+	// A run may overshoot the frame width, and outIndex wraps at 256
+	byte line[512];
+
+	f->pixels = new byte[f->width * f->height];
+	f->rowSpans = new uint32[f->height + 1];
+
+	for (int row = 0; row < f->height; ++row) {
+		decodeFrameLine(line, data + READ_LE_UINT16(data + row * 2), f->width);
+		memcpy(f->pixels + row * f->width, line, f->width);
+	}
+
+	f->findSpans();
+
+	return f;
+}
+
+/**
+ * Fills rowSpans and spans from the pixels. rowSpans must already hold
+ * height + 1 entries.
+ */
+void ActorFrame::findSpans() {
+	spans.clear();
+
+	for (int row = 0; row < height; ++row) {
+		const byte *p = getRow(row);
+
+		rowSpans[row] = spans.size();
+		for (int x = 0; x < width; ) {
+			if (p[x] == 0) {
+				x++;
+				continue;
+			}
+
+			int start = x;
+			while (x < width && p[x] != 0)
+				x++;
+			spans.push_back(start);
+			spans.push_back(x - start);
+		}
+	}
+	rowSpans[height] = spans.size();
+}
+
+void Actor::enable(int state) {
+	if ((state == 1) != (_isActive == 1))
+		_vm->actorMan()->invalidateDrawList();
+	_isActive = state;
+}
+
+void Actor::setMaskDepth(int maskDepth, int depth) {
+	if (depth != _depth)
+		_vm->actorMan()->invalidateDrawList();
+	_maskDepth = maskDepth;
+	_depth = depth;
+}
+
 void Actor::defineScope(uint8 scopeId, int16 minFrame, int16 maxFrame, int16 startFrame) {
 	assert(scopeId < 8);
 
@@ -329,10 +436,21 @@ void Actor::animate() {
 	}
 }
 
+/**
+ * Decodes every frame of the mouse actor into a cursor bitmap, so that
+ * no decoding happens while the cursor animates.
+ */
+void Actor::cacheCursors() {
+	for (int16 i = 0; i < _framesNum; ++i) {
+		const ActorFrame *f = getFrame(i);
+
+		if (f->width > 0 && f->height > 0)
+			_vm->screen()->cacheCursor(i, f);
+	}
+}
+
 void Actor::display() {
 	int16 frame;
-	int32 offset;
-	int16 width, height;
 	int32 xStart, yStart;
 	uint32 scaledWidth, scaledHeight;
 
@@ -344,23 +462,16 @@ void Actor::display() {
 	else
 		frame = _currentFrame;
 
-	MemoryReadStream frameStream(_framesData, _framesDataSize);
-
-	frameStream.seek(frame * 4);
-	offset = frameStream.readSint32LE() - 10;
-
-	frameStream.seek(offset);
-	width = frameStream.readSint16LE();
-	height = frameStream.readSint16LE();
+	const ActorFrame *f = getFrame(frame);
 
-	if (width <= 0 || height <= 0)
+	if (f->width <= 0 || f->height <= 0)
 		return;
 
-	xStart = _xPos + frameStream.readSint16LE() * _xRatio / 1024;
-	yStart = _yPos + frameStream.readSint16LE() * _yRatio / 1024;
+	xStart = _xPos + f->xOffset * _xRatio / 1024;
+	yStart = _yPos + f->yOffset * _yRatio / 1024;
 
-	scaledWidth = width * _xRatio / 1024;
-	scaledHeight = height * _yRatio / 1024;
+	scaledWidth = f->width * _xRatio / 1024;
+	scaledHeight = f->height * _yRatio / 1024;
 
 	_displayLeft = xStart;
 	_displayRight = xStart + scaledWidth - 1;
@@ -377,31 +488,28 @@ void Actor::display() {
 
 		// The loading icon is NOT a mouse cursor, but is stored in the mouse actor
 		if (_isMouse && _scope != 6) {
-			_vm->screen()->drawMouseFrame((int8 *)(_framesData + frameStream.pos()),
-												  width, height, xStart, yStart);
+			_vm->screen()->drawMouseFrame(frame, f, xStart, yStart);
 		} else {
 			//debug("drawing actor: %s", _name.c_str());
 			switch (_effect) {
 			case 4:
-				_vm->screen()->drawActorFrame((int8 *)(_framesData + frameStream.pos()),
-					width, height, xStart, yStart);
+				_vm->screen()->drawActorFrame(f, xStart, yStart);
 				break;
 			case 5:
 				// Used only when trying to cast Spell O' Kolagate Shield on another person
-				_vm->screen()->drawActorFrame((int8 *)(_framesData + frameStream.pos()),
-					width, height, xStart, yStart, /* greyed out */ true);
+				_vm->screen()->drawActorFrame(f, xStart, yStart, /* greyed out */ true);
 				break;
 			case 0:
-				_vm->screen()->drawActorFrameScaled((int8 *)(_framesData + frameStream.pos()),
-					width, height, xStart, yStart, xStart + scaledWidth - 1, yStart + scaledHeight - 1, _maskDepth);
+				_vm->screen()->drawActorFrameScaled(f,
+					xStart, yStart, xStart + scaledWidth - 1, yStart + scaledHeight - 1, _maskDepth);
 				break;
 			case 2:
-				_vm->screen()->drawActorFrameScaledAura((int8 *)(_framesData + frameStream.pos()),
-					width, height, xStart, yStart, xStart + scaledWidth - 1, yStart + scaledHeight - 1, _maskDepth);
+				_vm->screen()->drawActorFrameScaledAura(f,
+					xStart, yStart, xStart + scaledWidth - 1, yStart + scaledHeight - 1, _maskDepth);
 				break;
 			case 3:
-				_vm->screen()->drawActorFrameScaled((int8 *)(_framesData + frameStream.pos()),
-					width, height, xStart, yStart, xStart + scaledWidth - 1, yStart + scaledHeight - 1, _maskDepth, /*invisible=*/true);
+				_vm->screen()->drawActorFrameScaled(f,
+					xStart, yStart, xStart + scaledWidth - 1, yStart + scaledHeight - 1, _maskDepth, /*invisible=*/true);
 				break;
 			default:
 				warning("Unhandled effect %d", _effect);
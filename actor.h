@@ -40,6 +40,28 @@ struct Scope {
 	const int16* aliasData;
 };
 
+/**
+ * A frame of an actor, decoded from the .act RLE data on first use.
+ * Rows are stored one after another, and 0 is transparent. The opaque
+ * pixels of row n are the (start, length) pairs in
+ * spans[rowSpans[n]] up to spans[rowSpans[n + 1]].
+ */
+struct ActorFrame {
+	ActorFrame() : width(0), height(0), xOffset(0), yOffset(0), pixels(0), rowSpans(0) {}
+	~ActorFrame() { delete[] pixels; delete[] rowSpans; }
+
+	const byte *getRow(int row) const { return pixels + row * width; }
+	void findSpans();
+
+	int16 width;
+	int16 height;
+	int16 xOffset;
+	int16 yOffset;
+	byte *pixels;
+	uint32 *rowSpans;
+	Common::Array<uint16> spans;
+};
+
 class KomEngine;
 
 class Actor {
@@ -63,11 +85,12 @@ public:
 	void setAnim(int16 minFrame, int16 maxFrame, uint16 animDuration);
 	void animate();
 	void display();
+	void cacheCursors();
 
-	void enable(int state) { _isActive = state; }
+	void enable(int state);
 	void setPos(int xPos, int yPos) { _xPos = xPos; _yPos = yPos; }
 	void setRatio(uint16 xRatio, uint16 yRatio) { _xRatio = xRatio; _yRatio = yRatio; }
-	void setMaskDepth(int maskDepth, int depth) { _maskDepth = maskDepth; _depth = depth; }
+	void setMaskDepth(int maskDepth, int depth);
 	void setEffect(uint8 effect) { _effect = effect; }
 	void setFrame(int16 frame) { _currentFrame = frame; }
 	int getXPos() { return _xPos; }
@@ -111,8 +134,11 @@ protected:
 
 private:
 
+	const ActorFrame *getFrame(int16 frame);
+
 	byte *_framesData;
 	int _framesDataSize;
+	Common::Array<ActorFrame *> _frames;
 
 	KomEngine *_vm;
 
@@ -143,11 +169,15 @@ public:
 	Actor *getCloudWordActor() { return get(_cloudWordActorId); }
 	Actor *getNPCCloudActor(int i) { return get(_cloudNPC[i]); }
 	Actor *getMagicDarkLord(int i) { return get(_magicDarkLord[i]); }
-	void unload(int idx) { if (idx >= 0) { delete _actors[idx]; _actors[idx] = 0; } }
+	void unload(int idx) { if (idx >= 0) { delete _actors[idx]; _actors[idx] = 0; _drawListValid = false; } }
 	void unloadAll() { for (uint i = 0; i < _actors.size(); i++) unload(i); }
 	void displayAll();
 	void pauseAnimAll(bool pause);
 
+	/** Active actors with a positive depth, farthest first */
+	const Common::Array<Actor *> &getDrawList();
+	void invalidateDrawList() { _drawListValid = false; }
+
 private:
 
 	KomEngine *_vm;
@@ -165,7 +195,8 @@ private:
 	int _cloudNPC[4];
 	int _magicDarkLord[10];
 
-	Actor *getFarthestActor();
+	Common::Array<Actor *> _drawList;
+	bool _drawListValid;
 };
 
 } // End of namespace Kom
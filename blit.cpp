@@ -0,0 +1,55 @@
+/* ScummVM - Graphic Adventure Engine
+ *
+ * ScummVM is the legal property of its developers, whose names
+ * are too numerous to list here. Please refer to the COPYRIGHT
+ * file distributed with this source distribution.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ *
+ */
+
+#include "common/system.h"
+
+#include "kom/blit.h"
+
+namespace Kom {
+
+typedef void (*BlendRowProc)(byte *, const byte *, const byte *, uint);
+
+static BlendRowProc selectBlendRow() {
+#ifdef SCUMMVM_NEON
+	if (g_system->hasFeature(OSystem::kFeatureCpuNEON))
+		return blendRowNEON;
+#endif
+#ifdef SCUMMVM_SSE2
+	if (g_system->hasFeature(OSystem::kFeatureCpuSSE2))
+		return blendRowSSE2;
+#endif
+	return blendRowGeneric;
+}
+
+void blendRow(byte *dst, const byte *src, const byte *values, uint count) {
+	static BlendRowProc proc = selectBlendRow();
+
+	proc(dst, src, values, count);
+}
+
+void blendRowGeneric(byte *dst, const byte *src, const byte *values, uint count) {
+	for (uint i = 0; i < count; ++i)
+		if (src[i] != 0)
+			dst[i] = values[i];
+}
+
+} // End of namespace Kom
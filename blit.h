@@ -0,0 +1,48 @@
+/* ScummVM - Graphic Adventure Engine
+ *
+ * ScummVM is the legal property of its developers, whose names
+ * are too numerous to list here. Please refer to the COPYRIGHT
+ * file distributed with this source distribution.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ *
+ */
+
+#ifndef KOM_BLIT_H
+#define KOM_BLIT_H
+
+#include "common/scummsys.h"
+
+namespace Kom {
+
+/**
+ * Copies count pixels from values to dst, where src is non-zero.
+ * values may point into dst, as long as it is ahead of it.
+ */
+void blendRow(byte *dst, const byte *src, const byte *values, uint count);
+
+void blendRowGeneric(byte *dst, const byte *src, const byte *values, uint count);
+
+#ifdef SCUMMVM_SSE2
+void blendRowSSE2(byte *dst, const byte *src, const byte *values, uint count);
+#endif
+
+#ifdef SCUMMVM_NEON
+void blendRowNEON(byte *dst, const byte *src, const byte *values, uint count);
+#endif
+
+} // End of namespace Kom
+
+#endif
@@ -0,0 +1,47 @@
+/* ScummVM - Graphic Adventure Engine
+ *
+ * ScummVM is the legal property of its developers, whose names
+ * are too numerous to list here. Please refer to the COPYRIGHT
+ * file distributed with this source distribution.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ *
+ */
+
+#include <arm_neon.h>
+
+#include "kom/blit.h"
+
+namespace Kom {
+
+void blendRowNEON(byte *dst, const byte *src, const byte *values, uint count) {
+	uint i = 0;
+
+	for (; i + 16 <= count; i += 16) {
+		uint8x16_t s = vld1q_u8(src + i);
+		uint8x16_t v = vld1q_u8(values + i);
+		uint8x16_t d = vld1q_u8(dst + i);
+
+		// Select where src != 0
+		uint8x16_t sel = vtstq_u8(s, s);
+
+		vst1q_u8(dst + i, vbslq_u8(sel, v, d));
+	}
+
+	if (i < count)
+		blendRowGeneric(dst + i, src + i, values + i, count - i);
+}
+
+} // End of namespace Kom
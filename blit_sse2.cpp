@@ -0,0 +1,49 @@
+/* ScummVM - Graphic Adventure Engine
+ *
+ * ScummVM is the legal property of its developers, whose names
+ * are too numerous to list here. Please refer to the COPYRIGHT
+ * file distributed with this source distribution.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ *
+ */
+
+#include <emmintrin.h>
+
+#include "kom/blit.h"
+
+namespace Kom {
+
+void blendRowSSE2(byte *dst, const byte *src, const byte *values, uint count) {
+	const __m128i zero = _mm_setzero_si128();
+	uint i = 0;
+
+	for (; i + 16 <= count; i += 16) {
+		__m128i s = _mm_loadu_si128((const __m128i *)(src + i));
+		__m128i v = _mm_loadu_si128((const __m128i *)(values + i));
+		__m128i d = _mm_loadu_si128((const __m128i *)(dst + i));
+
+		// Keep dst where src == 0
+		__m128i keep = _mm_cmpeq_epi8(s, zero);
+
+		d = _mm_or_si128(_mm_andnot_si128(keep, v), _mm_and_si128(keep, d));
+		_mm_storeu_si128((__m128i *)(dst + i), d);
+	}
+
+	if (i < count)
+		blendRowGeneric(dst + i, src + i, values + i, count - i);
+}
+
+} // End of namespace Kom
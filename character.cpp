@@ -296,6 +296,64 @@ void Character::moveChar(bool param) {
 	}
 }
 
+/**
+ * Same as moveChar(), but skips the step for a character outside the
+ * player's location when its previous step left its state unchanged.
+ * moveChar() only depends on the player's location for the walking
+ * direction, so there a step that changed nothing will change nothing
+ * again, and skipping it is exact.
+ */
+void Character::moveCharSettled(bool param) {
+	MoveState before;
+	bool offscreen = _lastLocation != _vm->database()->getChar(0)->_lastLocation;
+
+	getMoveState(&before, param);
+
+	if (offscreen && _settled && before == _settledState)
+		return;
+
+	moveChar(param);
+
+	getMoveState(&_settledState, param);
+	_settled = offscreen && before == _settledState;
+}
+
+void Character::getMoveState(MoveState *s, bool param) const {
+	s->param = param;
+	s->lastLocation = _lastLocation;
+	s->lastBox = _lastBox;
+	s->gotoLoc = _gotoLoc;
+	s->gotoX = _gotoX;
+	s->gotoY = _gotoY;
+	s->screenX = _screenX;
+	s->screenY = _screenY;
+	s->priority = _priority;
+	s->scopeWanted = _scopeWanted;
+	s->start3 = _start3;
+	s->start4 = _start4;
+	s->start5 = _start5;
+	s->somethingX = _somethingX;
+	s->somethingY = _somethingY;
+	s->walkSpeed = _walkSpeed;
+	s->relativeSpeed = _relativeSpeed;
+	s->direction = _direction;
+	s->lastDirection = _lastDirection;
+	s->stopped = _stopped;
+}
+
+bool MoveState::operator==(const MoveState &s) const {
+	return param == s.param &&
+		lastLocation == s.lastLocation && lastBox == s.lastBox &&
+		gotoLoc == s.gotoLoc && gotoX == s.gotoX && gotoY == s.gotoY &&
+		screenX == s.screenX && screenY == s.screenY &&
+		priority == s.priority && scopeWanted == s.scopeWanted &&
+		start3 == s.start3 && start4 == s.start4 && start5 == s.start5 &&
+		somethingX == s.somethingX && somethingY == s.somethingY &&
+		walkSpeed == s.walkSpeed && relativeSpeed == s.relativeSpeed &&
+		direction == s.direction && lastDirection == s.lastDirection &&
+		stopped == s.stopped;
+}
+
 void Character::moveCharOther() {
 
 	// Height
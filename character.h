@@ -32,29 +32,129 @@ namespace Kom {
 
 class KomEngine;
 
+/** The fields read and written by Character::moveChar() */
+struct MoveState {
+	bool param;
+	int32 lastLocation;
+	int32 lastBox;
+	int16 gotoLoc;
+	int16 gotoX;
+	int16 gotoY;
+	int16 screenX;
+	int16 screenY;
+	int16 priority;
+	int16 scopeWanted;
+	int32 start3;
+	int32 start4;
+	int32 start5;
+	int32 somethingX;
+	int32 somethingY;
+	uint16 walkSpeed;
+	uint16 relativeSpeed;
+	uint16 direction;
+	uint16 lastDirection;
+	bool stopped;
+
+	bool operator==(const MoveState &s) const;
+};
+
 struct Character {
 public:
 	Character() :
 		_id(-1),
 		_mode(0), _modeCount(0), _isBusy(false), _isAlive(true), _isVisible(true),
-		_spellMode(0), _gold(0),
-		_actorId(-1), _screenH(0), _screenHDelta(0), _height(0),
+		_spellMode(0),
+		_actorId(-1), _scopeInUse(-1), _scopeWanted(8), _priority(0),
+		_start3(0), _start3Prev(0), _start3PrevPrev(0),
+		_start4(0), _start4Prev(0), _start4PrevPrev(0),
+		_start5(0), _start5Prev(0), _start5PrevPrev(0),
+		_somethingX(0), _somethingY(0),
+		_relativeSpeed(1024), _direction(0), _lastDirection(2),
+		_stopped(true), _stoppedTime(0),
+		_screenH(0), _screenHDelta(0), _height(0),
 		_offset14(262144), _offset1c(0), _offset20(262144), _offset28(0), _ratioX(262144),
-		_ratioY(262144), _relativeSpeed(1024), _direction(0), _lastDirection(2),
-		_stopped(true), _stoppedTime(0), _spriteName(0),
-		_scopeInUse(-1), _scopeWanted(8), _loadedScopeXtend(-1), _priority(0), _fightPartner(-1),
-		_spriteCutState(0), _spriteScope(0), _spriteTimer(0), _spriteBox(0), _somethingX(0),
-		_somethingY(0), _start3(0), _start3Prev(0), _start3PrevPrev(0), _start4(0),
-		_start4Prev(0), _start4PrevPrev(0), _start5(0), _start5Prev(0), _start5PrevPrev(0) {}
+		_ratioY(262144), _fightPartner(-1),
+		_spriteCutState(0), _spriteScope(0), _spriteTimer(0), _spriteBox(0),
+		_settled(false),
+		_gold(0), _spriteName(0), _loadedScopeXtend(-1) {}
+
+	// The fields up to _spriteType are read or written by the per-tick
+	// loops over all characters (processChars, loopMove, loopCollide and
+	// Screen::processGraphics). They are kept together, ahead of the bulky
+	// data, so those loops only touch the first few cache lines of each
+	// character.
 
 	int _id;
+	int _proc;
+	uint16 _mode;
+	uint16 _modeCount;
+	bool _isBusy;
+	bool _isAlive;
+	bool _isVisible;
+	uint8 _spellMode;
+	int16 _spellDuration;
+
+	// movement
+	int32 _lastLocation;
+	int32 _lastBox;
+	int16 _gotoLoc;
+	int32 _gotoBox;
+	int16 _gotoX;
+	int16 _gotoY;
+	int16 _destLoc;
+	int16 _destBox;
+	int32 _runawayLocation;
+	int16 _actorId;
+	int16 _scopeInUse;
+	int16 _scopeWanted;
+	int16 _screenX;
+	int16 _screenY;
+	int16 _priority;
+	int32 _start3;
+	int32 _start3Prev;
+	int32 _start3PrevPrev;
+	int32 _start4;
+	int32 _start4Prev;
+	int32 _start4PrevPrev;
+	int32 _start5;
+	int32 _start5Prev;
+	int32 _start5PrevPrev;
+	int32 _somethingX;
+	int32 _somethingY;
+	uint16 _walkSpeed;
+	uint16 _relativeSpeed;
+	uint16 _direction;
+	uint16 _lastDirection;
+	bool _stopped;
+	uint16 _stoppedTime;
+
+	// height and scaling
+	int32 _screenH;
+	int32 _screenHDelta;
+	int32 _height;
+	int32 _offset14;
+	int32 _offset1c;
+	int32 _offset20;
+	int32 _offset28;
+	int32 _ratioX;
+	int32 _ratioY;
+
+	int16 _fightPartner;
+	uint8 _spriteCutState;
+	uint16 _spriteScope;
+	uint16 _spriteTimer;
+	uint16 _spriteBox;
+	uint16 _spriteType;
+
+	// Set when the last moveCharSettled() step changed nothing
+	bool _settled;
+	MoveState _settledState;
 
 	// character
 	char _name[7];
 	int _xtend;
 	int _type;
 	char _desc[50];
-	int _proc;
 	int _locationId;
 	int _box;
 	int _data5;
@@ -64,13 +164,6 @@ public:
 	int _isMortal;
 	int _hitPoints;
 	int _hitPointsMax;
-	uint16 _mode;
-	uint16 _modeCount;
-	bool _isBusy;
-	bool _isAlive;
-	bool _isVisible;
-	uint8 _spellMode;
-	int16 _spellDuration;
 	int _strength;
 	int _defense;
 	int _oldHitPoints;
@@ -83,8 +176,6 @@ public:
 	int _data16;
 	int _spellPoints;
 	int _spellPointsMax;
-	int16 _destLoc;
-	int16 _destBox;
 	int _gold;
 	Common::List<int> _inventory;
 	Common::List<int> _weapons;
@@ -92,58 +183,14 @@ public:
 
 	// scope
 	Scope _scopes[18];
-	int16 _actorId;
-	int16 _screenX;
-	int16 _screenY;
-	int32 _screenH;
-	int32 _screenHDelta;
-	int32 _height;
-	int32 _offset14;
-	int32 _offset1c;
-	int32 _offset20;
-	int32 _offset28;
-	int32 _ratioX;
-	int32 _ratioY;
-	int16 _priority;
-	int32 _lastLocation;
-	int32 _runawayLocation;
-	int32 _lastBox;
-	int32 _gotoBox;
-	int16 _gotoX;
-	int16 _gotoY;
-	int16 _gotoLoc;
-	uint16 _walkSpeed;
-	uint16 _relativeSpeed;
 	uint16 _animSpeed;
-	uint16 _direction;
-	uint16 _lastDirection;
-	bool _stopped;
-	uint16 _stoppedTime;
 	uint16 _timeout;
-	int32 _start3;
-	int32 _start3Prev;
-	int32 _start3PrevPrev;
-	int32 _start4;
-	int32 _start4Prev;
-	int32 _start4PrevPrev;
-	int32 _somethingX;
-	int32 _somethingY;
-	int32 _start5;
-	int32 _start5Prev;
-	int32 _start5PrevPrev;
 	int32 _offset78;
-	int16 _fightPartner;
-	uint8 _spriteCutState;
-	uint16 _spriteScope;
-	uint16 _spriteTimer;
-	uint16 _spriteBox;
-	uint16 _spriteType;
 	const char *_spriteName;
-	int16 _scopeInUse;
-	int16 _scopeWanted;
 	int16 _loadedScopeXtend;
 
 	void moveChar(bool param);
+	void moveCharSettled(bool param);
 	void moveCharOther();
 	void stopChar();
 	void hitExit(bool checkHousing);
@@ -157,6 +204,7 @@ private:
 	void setAnimation(int16 anim, int16 scope);
 
 	void housingProblem();
+	void getMoveState(MoveState *s, bool param) const;
 
 protected:
 	static KomEngine *_vm;
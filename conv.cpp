@@ -830,24 +830,83 @@ void Talk::doTalk(int charId, int emotion, const char *sampleFile, const char *s
 	Lips::doTalk(id, emotion, sampleFile, sentence, pitch);
 }
 
-Conv::Conv(KomEngine *vm, uint16 charId)
-	: _vm(vm), _convs(0), _text(0) {
-	_charId = charId;
-	_codename = _vm->database()->getChar(charId)->_name;
+// Memory the conversation cache may hold on to
+static const uint32 kConvCacheBudget = 512 * 1024;
+
+ConvCache::ConvCache(KomEngine *vm)
+	: _vm(vm), _size(0) {
 	_convData = _vm->database()->getConvData();
-	_convEntry = _vm->database()->getConvIndex(_codename);
+}
 
-	_vm->screen()->showMouseCursor(false);
+ConvCache::~ConvCache() {
+	for (Common::List<ConvData *>::iterator i = _entries.begin(); i != _entries.end(); ++i)
+		delete *i;
 }
 
-Conv::~Conv() {
-	delete[] _convs;
-	delete[] _text;
+/**
+ * Returns the entry for a character, creating it if needed, and marks it
+ * as the most recently used one.
+ */
+ConvData *ConvCache::find(const byte *convEntry) {
+	for (Common::List<ConvData *>::iterator i = _entries.begin(); i != _entries.end(); ++i) {
+		if ((*i)->convEntry == convEntry) {
+			ConvData *data = *i;
+			_entries.erase(i);
+			_entries.push_front(data);
+			return data;
+		}
+	}
 
-	_vm->screen()->showMouseCursor(true);
+	ConvData *data = new ConvData(convEntry);
+	_entries.push_front(data);
+	_size += data->size;
+	return data;
+}
+
+/**
+ * Drops least recently used entries until the cache fits its budget.
+ * The entry that was just requested is always kept.
+ */
+void ConvCache::prune(ConvData *keep) {
+	while (_size > kConvCacheBudget && _entries.back() != keep) {
+		ConvData *data = _entries.back();
+		_entries.pop_back();
+		_size -= data->size;
+		delete data;
+	}
 }
 
-void Conv::initConvs(uint32 offset) {
+ConvData *ConvCache::getTalk(const byte *convEntry) {
+	ConvData *data = find(convEntry);
+
+	if (!data->talkLoaded) {
+		uint32 oldSize = data->size;
+		loadConversations(data, READ_LE_UINT32(convEntry + 20));
+		data->text = loadText(data, READ_LE_UINT32(convEntry + 8));
+		data->talkLoaded = true;
+		_size += data->size - oldSize;
+		prune(data);
+	}
+
+	return data;
+}
+
+ConvData *ConvCache::getResponses(const byte *convEntry) {
+	ConvData *data = find(convEntry);
+
+	if (!data->responsesLoaded) {
+		uint32 oldSize = data->size;
+		data->responseText = loadText(data, READ_LE_UINT32(convEntry + 12));
+		loadResponses(data, READ_LE_UINT32(convEntry + 16));
+		data->responsesLoaded = true;
+		_size += data->size - oldSize;
+		prune(data);
+	}
+
+	return data;
+}
+
+void ConvCache::loadConversations(ConvData *data, uint32 offset) {
 	int16 charId, cmd;
 	int32 optNum;
 	Common::String lineBuffer;
@@ -937,6 +996,7 @@ void Conv::initConvs(uint32 offset) {
 				sscanf(lineBuffer.c_str(), "%hd", &cmd);
 			}
 
+			data->size += sizeof(Option) + optObject.statements.size() * sizeof(Statement);
 			convObject.options.push_back(optObject);
 
 			do {
@@ -945,7 +1005,8 @@ void Conv::initConvs(uint32 offset) {
 			sscanf(lineBuffer.c_str(), "%d", &optNum);
 		}
 
-		_conversations.push_back(convObject);
+		data->size += sizeof(Conversation);
+		data->conversations.push_back(convObject);
 
 		do {
 			lineBuffer = _convData->readLine();
@@ -954,24 +1015,62 @@ void Conv::initConvs(uint32 offset) {
 	}
 }
 
-void Conv::initText(uint32 offset) {
+char *ConvCache::loadText(ConvData *data, uint32 offset) {
 	int num;
+	char *text;
 	Common::String lineBuffer;
 
 	_convData->seek(offset);
 	lineBuffer = _convData->readLine();
 	sscanf(lineBuffer.c_str(), "%d", &num);
-	_text = new char[num];
-	_convData->read(_text, num);
+	text = new char[num];
+	_convData->read(text, num);
+	data->size += num;
+
+	return text;
+}
+
+void ConvCache::loadResponses(ConvData *data, uint32 offset) {
+	int count;
+	Common::String lineBuffer;
+
+	_convData->seek(offset);
+	lineBuffer = _convData->readLine();
+	sscanf(lineBuffer.c_str(), "%d", &count);
+
+	data->responses.resize(count);
+	for (int i = 0; i < count; i++) {
+		Response *r = &data->responses[i];
+
+		do {
+			lineBuffer = _convData->readLine();
+		} while (lineBuffer.empty());
+		sscanf(lineBuffer.c_str(), "%d %d %d", &r->num, &r->emotion, &r->offset);
+	}
+
+	data->size += count * sizeof(Response);
+}
+
+Conv::Conv(KomEngine *vm, uint16 charId)
+	: _vm(vm), _text(0) {
+	_charId = charId;
+	_codename = _vm->database()->getChar(charId)->_name;
+	_convEntry = _vm->database()->getConvIndex(_codename);
+
+	_vm->screen()->showMouseCursor(false);
+}
+
+Conv::~Conv() {
+	_vm->screen()->showMouseCursor(true);
 }
 
 bool Conv::doTalk(int16 convNum, int32 optNum) {
+	ConvData *data = _vm->database()->convCache()->getTalk(_convEntry);
 
-	initConvs(READ_LE_UINT32(_convEntry + 20));
-	initText(READ_LE_UINT32(_convEntry + 8));
+	_text = data->text;
 
 	// Find conversation
-	for (Common::List<Conversation>::iterator c = _conversations.begin(); c != _conversations.end(); c++) {
+	for (Common::List<Conversation>::iterator c = data->conversations.begin(); c != data->conversations.end(); c++) {
 		if (_charId == c->charId && c->convNum == convNum) {
 			Talk talk(_vm);
 			talk.init(_charId, convNum);
@@ -984,24 +1083,18 @@ bool Conv::doTalk(int16 convNum, int32 optNum) {
 }
 
 void Conv::doResponse(int responseNum) {
-	int count;
 	int num = -1;
 	int offset = 0;
 	int emotion;
 	char convName[10];
-	Common::String lineBuffer;
-
-	initText(READ_LE_UINT32(_convEntry + 12));
+	ConvData *data = _vm->database()->convCache()->getResponses(_convEntry);
 
-	_convData->seek(READ_LE_UINT32(_convEntry + 16));
-	lineBuffer = _convData->readLine();
-	sscanf(lineBuffer.c_str(), "%d", &count);
+	_text = data->responseText;
 
-	for (int i = 0; i < count && num != responseNum; i++) {
-		do {
-			lineBuffer = _convData->readLine();
-		} while (lineBuffer.empty());
-		sscanf(lineBuffer.c_str(), "%d %d %d", &num, &emotion, &offset);
+	for (uint i = 0; i < data->responses.size() && num != responseNum; i++) {
+		num = data->responses[i].num;
+		emotion = data->responses[i].emotion;
+		offset = data->responses[i].offset;
 	}
 
 	if (num != responseNum) {
@@ -24,6 +24,7 @@
 #define KOM_CONV_H
 
 #include "common/scummsys.h"
+#include "common/array.h"
 #include "common/list.h"
 #include "common/str.h"
 
@@ -76,6 +77,63 @@ struct Conversation {
 	Common::List<Option> options;
 };
 
+struct Response {
+	int num;
+	int emotion;
+	int offset;
+};
+
+/**
+ * Everything Conv reads from conv.bin for one character. The talk and
+ * response parts are loaded independently, on first use.
+ */
+struct ConvData {
+	ConvData(const byte *entry) : convEntry(entry), talkLoaded(false), responsesLoaded(false),
+		text(0), responseText(0), size(sizeof(ConvData)) {}
+	~ConvData() { delete[] text; delete[] responseText; }
+
+	const byte *convEntry;
+	bool talkLoaded;
+	bool responsesLoaded;
+
+	Common::List<Conversation> conversations;
+	char *text;
+
+	Common::Array<Response> responses;
+	char *responseText;
+
+	uint32 size;
+};
+
+/**
+ * Keeps the parsed conversations of recently talked to characters, so
+ * talking to them again does not re-read and re-parse conv.bin.
+ * Least recently used entries are dropped once the budget is exceeded.
+ */
+class ConvCache {
+public:
+	ConvCache(KomEngine *vm);
+	~ConvCache();
+
+	ConvData *getTalk(const byte *convEntry);
+	ConvData *getResponses(const byte *convEntry);
+
+private:
+	ConvData *find(const byte *convEntry);
+	void prune(ConvData *keep);
+
+	void loadConversations(ConvData *data, uint32 offset);
+	char *loadText(ConvData *data, uint32 offset);
+	void loadResponses(ConvData *data, uint32 offset);
+
+	KomEngine *_vm;
+	Common::File *_convData;
+
+	// Most recently used first
+	Common::List<ConvData *> _entries;
+	uint32 _size;
+};
+
 struct Loop {
 	int16 startFrame;
 	int16 endFrame;
@@ -213,9 +271,6 @@ public:
 	void doResponse(int responseNum);
 
 private:
-	void initConvs(uint32 offset);
-	void initText(uint32 offset);
-
 	bool doOptions(Talk &talk, Conversation *conv, int32 optNum);
 	int doStat(Talk &talk, int selection);
 
@@ -224,14 +279,10 @@ private:
 	uint16 _charId;
 	const char *_codename;
 	byte *_convEntry;
-	Common::File *_convData;
 
-	byte *_convs;
 	char *_text;
 
 	OptionLine _options[3];
-
-	Common::List<Conversation> _conversations;
 };
 
 } // End of namespace Kom
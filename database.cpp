@@ -24,17 +24,23 @@
 #include <stdlib.h>
 #include <string.h>
 
+#include "common/algorithm.h"
 #include "common/debug.h"
 #include "common/file.h"
+#include "common/hashmap.h"
+#include "common/hash-str.h"
 #include "common/list.h"
 #include "common/util.h"
 #include "common/endian.h"
+#include "common/memstream.h"
+#include "common/savefile.h"
 #include "common/textconsole.h"
 
 #include "kom/kom.h"
 #include "kom/actor.h"
 #include "kom/database.h"
 #include "kom/character.h"
+#include "kom/conv.h"
 #include "kom/game.h"
 
 using Common::File;
@@ -44,17 +50,40 @@ namespace Kom {
 
 const int Database::_locRoutesSize = 111;
 
+// Commands that Database::indexProcs() groups for direct lookup
+static const int kFirstIndexedCmd = 312;
+static const int kLastIndexedCmd = 324;
+
+// Bump whenever the layout written by saveCache() changes
+static const uint32 kCacheVersion = 4;
+
+// Size and checksum of each source file, see getSourceFingerprint()
+static const int kCacheSourcesNum = 9;
+static const uint32 kCacheHeaderSize = 16 + 8 * kCacheSourcesNum;
+
+// Bytes read from each end of a source file for its fingerprint
+static const uint32 kFingerprintSpan = 256;
+
 Database::Database(KomEngine *vm)
 	: _vm(vm) {
 	_locations = 0;
 	_characters = 0;
 	_objects = 0;
+	_processes = 0;
+	_variables = 0;
 
 	_routes = 0;
 	_map = 0;
 	_locRoutes = 0;
 
+	memset(_boxRoutes, 0, sizeof(_boxRoutes));
+	_boxDistances = 0;
+	_locDistances = 0;
+	_exitBoxes = 0;
+	_boxGrids = 0;
+
 	_convData = 0;
+	_convCache = 0;
 }
 
 Database::~Database() {
@@ -66,11 +95,16 @@ Database::~Database() {
 	delete[] _convIndex;
 	delete[] _narrIndex;
 	_narrData.close();
+	delete _convCache;
 	_convData->close();
 	delete _convData;
 	delete[] _routes;
 	delete[] _map;
 	delete[] _locRoutes;
+	delete[] _boxDistances;
+	delete[] _locDistances;
+	delete[] _exitBoxes;
+	delete[] _boxGrids;
 }
 
 void Database::init(Common::String databasePrefix) {
@@ -83,30 +117,103 @@ void Database::init(Common::String databasePrefix) {
 
 	_convData = new File();
 	_convData->open(_pathPrefix / ("conv.bin"));
+	_convCache = new ConvCache(_vm);
+
+	Character::_vm = _vm;
 
 	loadConvIndex();
 	loadNarratorIndex();
-	initLocations();
-	initCharacters();
-	initObjects();
-	initEvents();
+
+	if (!loadCache()) {
+		initLocations();
+		initCharacters();
+		initObjects();
+		initEvents();
+		initProcs();
+		compileProcs();
+		initRoutes();
+		saveCache();
+	}
+
+	indexProcs();
+	initRouteTables();
+	initBoxGrids();
 	initObjectLocs();
 	initCharacterLocs();
-	initProcs();
-	initRoutes();
-
 
 	for (int i = 0; i < _procsNum; ++i) {
-		for (Common::List<Command>::iterator j = _processes[i].commands.begin();
-				j != _processes[i].commands.end(); ++j) {
-			if (j->cmd == 312) { // Init
-				debug(1, "Processing init in %s", _processes[i].name);
-				_vm->game()->doStat(&(*j));
-			}
+		uint count;
+		const Command *init = findCommands(&_processes[i], 312, &count);
+
+		for (uint j = 0; j < count; ++j) {
+			debug(1, "Processing init in %s", _processes[i].name);
+			_vm->game()->doStat(&init[j]);
 		}
 	}
 }
 
+// Conversation and narrator index records start with an 8-byte name
+static const int kIndexNameSize = 8;
+
+namespace {
+
+struct IndexNameLess {
+	const byte *_records;
+	uint32 _recordSize;
+
+	IndexNameLess(const byte *records, uint32 recordSize) : _records(records), _recordSize(recordSize) {}
+
+	bool operator()(uint32 a, uint32 b) const {
+		int cmp = strncmp((const char *)_records + a * _recordSize,
+		                  (const char *)_records + b * _recordSize, kIndexNameSize);
+
+		// Equal names keep their file order
+		return cmp < 0 || (cmp == 0 && a < b);
+	}
+};
+
+} // End of anonymous namespace
+
+/**
+ * Fills sorted with the record numbers ordered by name.
+ */
+static void sortIndex(const byte *records, uint32 count, uint32 recordSize, Common::Array<uint32> &sorted) {
+	sorted.resize(count);
+	for (uint32 i = 0; i < count; ++i)
+		sorted[i] = i;
+
+	Common::sort(sorted.begin(), sorted.end(), IndexNameLess(records, recordSize));
+}
+
+/**
+ * Binary search for the first record (in file order) whose name starts
+ * with entry, which is what the original linear strncmp scan returned.
+ * Returns the record number, or -1.
+ */
+static int findIndex(const byte *records, uint32 recordSize, const Common::Array<uint32> &sorted, const char *entry) {
+	int entrySize = strlen(entry);
+	uint32 first = 0, last = sorted.size();
+
+	while (first < last) {
+		uint32 mid = (first + last) / 2;
+		if (strncmp((const char *)records + sorted[mid] * recordSize, entry, kIndexNameSize) < 0)
+			first = mid + 1;
+		else
+			last = mid;
+	}
+
+	// All names with this prefix follow the lower bound
+	int result = -1;
+	for (; first < sorted.size(); ++first) {
+		if (strncmp(entry, (const char *)records + sorted[first] * recordSize, entrySize) != 0)
+			break;
+		if (result == -1 || sorted[first] < (uint32)result)
+			result = sorted[first];
+	}
+
+	return result;
+}
+
 void Database::loadConvIndex() {
 	File f;
 
@@ -115,6 +222,8 @@ void Database::loadConvIndex() {
 	_convIndex = new byte[_convIndexLen * 24];
 	f.read(_convIndex, _convIndexLen * 24);
 	f.close();
+
+	sortIndex(_convIndex, _convIndexLen, 24, _convSorted);
 }
 
 void Database::loadNarratorIndex() {
@@ -126,17 +235,18 @@ void Database::loadNarratorIndex() {
 	f.read(_narrIndex, _narrIndexSize);
 	f.close();
 
+	sortIndex(_narrIndex, _narrIndexSize / 16, 16, _narrSorted);
+
 	_narrData.open("kom/conv/narr.bin");
 }
 
 byte *Database::getConvIndex(const char *entry) {
-	int entrySize = strlen(entry);
+	int i = findIndex(_convIndex, 24, _convSorted, entry);
 
-	for (uint i = 0; i < _convIndexLen; i++)
-		if (strncmp(entry, (const char *)_convIndex + i * 24, entrySize) == 0)
-			return _convIndex + i * 24;
+	if (i < 0)
+		return 0;
 
-	return 0;
+	return _convIndex + i * 24;
 }
 
 /**
@@ -144,25 +254,21 @@ byte *Database::getConvIndex(const char *entry) {
  * Caller should delete it
  */
 char *Database::getNarratorText(const char *entry) {
-	int entrySize = strlen(entry);
+	int i = findIndex(_narrIndex, 16, _narrSorted, entry);
 	char *result;
 
-	for (int i = 0; i < _narrIndexSize; i+=16) {
+	if (i < 0)
+		return 0;
 
-		if (strncmp(entry, (const char *)_narrIndex + i, entrySize) == 0) {
-			uint32 offset = READ_LE_UINT32(_narrIndex + i + 8);
-			uint32 size = READ_LE_UINT32(_narrIndex + i + 12);
+	uint32 offset = READ_LE_UINT32(_narrIndex + i * 16 + 8);
+	uint32 size = READ_LE_UINT32(_narrIndex + i * 16 + 12);
 
-			result = new char[size + 1];
-			_narrData.seek(offset);
-			_narrData.read(result, size);
-			result[size] = '\0';
-
-			return result;
-		}
-	}
+	result = new char[size + 1];
+	_narrData.seek(offset);
+	_narrData.read(result, size);
+	result[size] = '\0';
 
-	return 0;
+	return result;
 }
 
 void Database::initLocations() {
@@ -222,7 +328,6 @@ void Database::initCharacters() {
 	sscanf(line.c_str(), "%d", &_charactersNum);
 
 	_characters = new Character[_charactersNum];
-	Character::_vm = _vm;
 
 	for (int i = 0; i < _charactersNum; ++i) {
 		int index;
@@ -707,6 +812,158 @@ void Database::initProcs() {
 	f.close();
 }
 
+/**
+ * Lowers the parsed opcode lists into one contiguous instruction array.
+ * String operands are interned, so each distinct string is stored once.
+ */
+void Database::compileProcs() {
+	Common::HashMap<Common::String, int16> stringIndex;
+
+	_code.clear();
+	_strings.clear();
+
+	for (int i = 0; i < _procsNum; ++i) {
+		for (Common::Array<Command>::iterator j = _processes[i].commands.begin();
+				j != _processes[i].commands.end(); ++j) {
+			j->code = _code.size();
+			j->codeSize = j->opcodes.size();
+
+			for (Common::List<OpCode>::const_iterator k = j->opcodes.begin(); k != j->opcodes.end(); ++k) {
+				Instruction ins;
+				ins.opcode = k->opcode;
+				ins.arg1 = -1;
+				ins.arg2 = k->arg2;
+				ins.arg3 = k->arg3;
+				ins.arg4 = k->arg4;
+				ins.arg5 = k->arg5;
+				ins.arg6 = k->arg6;
+
+				if (k->arg1[0] != '\0') {
+					Common::String str(k->arg1);
+					if (!stringIndex.contains(str)) {
+						stringIndex[str] = _strings.size();
+						_strings.push_back(str);
+					}
+					ins.arg1 = stringIndex[str];
+				}
+
+				_code.push_back(ins);
+			}
+
+			j->opcodes.clear();
+		}
+	}
+
+	debug(1, "Compiled %d instructions, %d strings", (int)_code.size(), (int)_strings.size());
+}
+
+/**
+ * Reorders the commands of every process so that those handling the same
+ * cmd are adjacent, keeping their script order, and records where each
+ * group starts. Use-with commands (320, 321) are further ordered by value.
+ */
+void Database::indexProcs() {
+	const int groups = kLastIndexedCmd - kFirstIndexedCmd + 1;
+
+	for (int i = 0; i < _procsNum; ++i) {
+		Process *p = &_processes[i];
+		Common::Array<Command> sorted;
+
+		sorted.reserve(p->commands.size());
+
+		for (int c = kFirstIndexedCmd; c <= kLastIndexedCmd; ++c) {
+			uint16 start = sorted.size();
+			p->cmdIndex[c - kFirstIndexedCmd] = start;
+
+			for (uint j = 0; j < p->commands.size(); ++j) {
+				if (p->commands[j].cmd != c)
+					continue;
+
+				uint k = sorted.size();
+				sorted.push_back(p->commands[j]);
+
+				if (c == 320 || c == 321) {
+					while (k > start && sorted[k - 1].value > sorted[k].value) {
+						SWAP(sorted[k - 1], sorted[k]);
+						--k;
+					}
+				}
+			}
+		}
+
+		p->cmdIndex[groups] = sorted.size();
+
+		// Anything else is kept at the end, grouped by cmd
+		for (uint j = 0; j < p->commands.size(); ++j) {
+			int c = p->commands[j].cmd;
+			if (c >= kFirstIndexedCmd && c <= kLastIndexedCmd)
+				continue;
+
+			uint k = sorted.size();
+			sorted.push_back(p->commands[j]);
+			while (k > p->cmdIndex[groups] && sorted[k - 1].cmd > c) {
+				SWAP(sorted[k - 1], sorted[k]);
+				--k;
+			}
+		}
+
+		p->commands = sorted;
+	}
+}
+
+/**
+ * Returns the commands of a process which handle cmd, in script order.
+ * The result is a contiguous run of count commands.
+ */
+const Command *Database::findCommands(const Process *proc, int cmd, uint *count) const {
+	uint start, end;
+
+	if (cmd >= kFirstIndexedCmd && cmd <= kLastIndexedCmd) {
+		start = proc->cmdIndex[cmd - kFirstIndexedCmd];
+		end = proc->cmdIndex[cmd - kFirstIndexedCmd + 1];
+	} else {
+		start = proc->cmdIndex[kLastIndexedCmd - kFirstIndexedCmd + 1];
+		while (start < proc->commands.size() && proc->commands[start].cmd != cmd)
+			++start;
+		end = start;
+		while (end < proc->commands.size() && proc->commands[end].cmd == cmd)
+			++end;
+	}
+
+	*count = end - start;
+	return *count ? &proc->commands[start] : NULL;
+}
+
+/**
+ * Same as above, but only returns the commands whose value matches.
+ * Only meaningful for the use-with commands, 320 and 321.
+ */
+const Command *Database::findCommands(const Process *proc, int cmd, int value, uint *count) const {
+	uint num;
+	const Command *cmds = findCommands(proc, cmd, &num);
+	uint first = 0, last = num;
+
+	*count = 0;
+	if (value < 0 || value > 0xFFFF)
+		return NULL;
+
+	// Lower bound
+	while (first < last) {
+		uint mid = (first + last) / 2;
+		if (cmds[mid].value < value)
+			first = mid + 1;
+		else
+			last = mid;
+	}
+
+	last = first;
+	while (last < num && cmds[last].value == value)
+		++last;
+
+	*count = last - first;
+	return *count ? &cmds[first] : NULL;
+}
+
 void Database::initRoutes() {
 	File f;
 	Common::String line;
@@ -813,6 +1070,161 @@ void Database::initRoutes() {
 	f.close();
 }
 
+// Longest route followed when building the distance tables, in case
+// the data contains a cycle
+static const int kMaxRouteHops = 64;
+
+// Marks a distance table entry which has to be found by walking the route
+static const uint8 kUnknownLocDistance = 0xFF;
+
+/**
+ * Precomputes the route lookups done every tick: where each location's
+ * box matrix lives in the map, how many box2box() and loc2loc() hops
+ * separate any two boxes or locations, and which exit leads to each
+ * neighbouring location.
+ */
+void Database::initRouteTables() {
+	for (int loc = 0; loc < ARRAYSIZE(_boxRoutes); ++loc) {
+		if ((loc + 1) * 4 <= _mapSize)
+			_boxRoutes[loc] = _map + READ_LE_UINT32(_map + loc * 4);
+		else
+			_boxRoutes[loc] = 0;
+	}
+
+	_boxDistances = new int8[_locRoutesSize * 32 * 32];
+	memset(_boxDistances, -1, _locRoutesSize * 32 * 32);
+
+	for (int loc = 0; loc < _locRoutesSize; ++loc) {
+		const byte *table = _boxRoutes[loc];
+		if (!table || table < _map || table >= _map + _mapSize)
+			continue;
+
+		int boxes = *(const int8 *)table;
+		if (boxes <= 0 || boxes > 32 || table + boxes * boxes + 1 > _map + _mapSize)
+			continue;
+
+		for (int to = 0; to < boxes; ++to) {
+			for (int from = 0; from < boxes; ++from) {
+				int currBox = from;
+				int distance = 0;
+
+				while (distance < kMaxRouteHops) {
+					currBox = box2box(loc, currBox, to);
+					if (currBox < 0 || currBox >= boxes)
+						break;
+					distance++;
+				}
+
+				// Routes leaving the matrix are left to boxDistance()
+				if (currBox == -1)
+					_boxDistances[(loc * 32 + to) * 32 + from] = distance;
+			}
+		}
+	}
+
+	_locDistancesNum = (int8)_routes[0];
+	if (_locDistancesNum < 0 || _locDistancesNum * _locDistancesNum + 1 > _routesSize)
+		_locDistancesNum = 0;
+
+	_locDistances = new uint8[_locDistancesNum * _locDistancesNum];
+	memset(_locDistances, kUnknownLocDistance, _locDistancesNum * _locDistancesNum);
+
+	for (int to = 0; to < _locDistancesNum; ++to) {
+		for (int from = 0; from < _locDistancesNum; ++from) {
+			int currLoc = from;
+			int distance = 0;
+
+			while (distance < kMaxRouteHops) {
+				currLoc = loc2loc(currLoc, to);
+				if (currLoc < 0 || currLoc >= _locDistancesNum)
+					break;
+				distance++;
+			}
+
+			if (currLoc == -1)
+				_locDistances[to * _locDistancesNum + from] = distance;
+		}
+	}
+
+	_exitBoxes = new uint16[_locRoutesSize * 128];
+	for (int loc = 0; loc < _locRoutesSize; ++loc) {
+		for (int next = 0; next < 128; ++next) {
+			uint16 exitBox = 0;
+
+			for (int i = 0; i < 6; ++i)
+				if (_locRoutes[loc].exits[i].exitLoc == next) {
+					exitBox = _locRoutes[loc].exits[i].exit;
+					break;
+				}
+
+			_exitBoxes[loc * 128 + next] = exitBox;
+		}
+	}
+}
+
+/**
+ * Builds the per-location box bitmasks used by whatBox(), whatBoxLinked()
+ * and getClosestBox(). Boxes never change once loaded.
+ */
+void Database::initBoxGrids() {
+	_boxGrids = new BoxGrid[_locRoutesSize];
+	memset(_boxGrids, 0, _locRoutesSize * sizeof(BoxGrid));
+
+	for (int loc = 0; loc < _locRoutesSize; ++loc) {
+		BoxGrid *grid = &_boxGrids[loc];
+
+		for (int i = 0; i < 32; ++i) {
+			const Box *box = &_locRoutes[loc].boxes[i];
+			uint32 bit = 1u << i;
+
+			if ((box->attrib & 14) == 0)
+				grid->linkable |= bit;
+
+			// Link targets outside the box table can't be narrowed down
+			grid->links[i] = bit;
+			for (int j = 0; j < 6; ++j) {
+				if (box->joins[j] >= 32)
+					grid->links[i] = 0xFFFFFFFF;
+				else if (box->joins[j] >= 0)
+					grid->links[i] |= 1u << box->joins[j];
+			}
+
+			if (!box->enabled) {
+				grid->disabled |= bit;
+				continue;
+			}
+
+			if ((box->attrib & 6) == 0)
+				grid->walkable |= bit;
+			if (box->attrib == 0)
+				grid->floor |= bit;
+
+			int col1 = MAX<int>(box->x1, 0) / kBoxGridCellSize;
+			int col2 = MIN<int>(box->x2, kBoxGridCols * kBoxGridCellSize - 1) / kBoxGridCellSize;
+			int row1 = MAX<int>(box->y1, 0) / kBoxGridCellSize;
+			int row2 = MIN<int>(box->y2, kBoxGridRows * kBoxGridCellSize - 1) / kBoxGridCellSize;
+
+			if (box->x2 >= 0 && box->x1 <= box->x2)
+				for (int col = col1; col <= col2; ++col)
+					grid->cols[col] |= bit;
+
+			if (box->y2 >= 0 && box->y1 <= box->y2)
+				for (int row = row1; row <= row2; ++row)
+					grid->rows[row] |= bit;
+
+			if (box->x2 >= 0 && box->x1 <= box->x2 && box->y2 >= 0 && box->y1 <= box->y2)
+				for (int row = row1; row <= row2; ++row)
+					for (int col = col1; col <= col2; ++col)
+						grid->cells[row][col] |= bit;
+		}
+	}
+}
+
+static inline bool inBoxGrid(int x, int y) {
+	return x >= 0 && x < kBoxGridCols * kBoxGridCellSize &&
+		y >= 0 && y < kBoxGridRows * kBoxGridCellSize;
+}
+
 void Database::initScopes() {
 	File f;
 	Common::String line;
@@ -893,21 +1305,578 @@ void Database::initScopes() {
 	f.close();
 }
 
+/**
+ * Adler-32 over the cache payload. Only meant to catch truncated or
+ * damaged cache files, not tampering.
+ */
+static uint32 cacheChecksum(const byte *data, uint32 size) {
+	uint32 a = 1, b = 0;
+
+	for (uint32 i = 0; i < size; ++i) {
+		a = (a + data[i]) % 65521;
+		b = (b + a) % 65521;
+	}
+
+	return (b << 16) | a;
+}
+
+/**
+ * Fills fingerprint with the size of each file the cached tables are
+ * built from and a checksum of its head and tail, so a cache is rebuilt
+ * when the game data changes without reading the files in full.
+ * Missing files are recorded as 0, 0.
+ */
+void Database::getSourceFingerprint(uint32 *fingerprint) const {
+	const Path sources[kCacheSourcesNum] = {
+		_pathPrefix / (_databasePrefix + ".loc"),
+		_pathPrefix / (_databasePrefix + ".chr"),
+		_pathPrefix / (_databasePrefix + ".obs"),
+		_pathPrefix / (_databasePrefix + ".box"),
+		_pathPrefix / (_databasePrefix + ".pro"),
+		_pathPrefix / (_databasePrefix + ".scp"),
+		_pathPrefix / "test0r.rou",
+		_pathPrefix / "test0r.map",
+		_pathPrefix / "test0r.ked"
+	};
+
+	for (int i = 0; i < kCacheSourcesNum; ++i) {
+		File f;
+		fingerprint[2 * i] = 0;
+		fingerprint[2 * i + 1] = 0;
+
+		if (!f.open(sources[i]))
+			continue;
+
+		byte data[2 * kFingerprintSpan];
+		uint32 size = f.size();
+		uint32 length = f.read(data, MIN(size, kFingerprintSpan));
+
+		if (size > kFingerprintSpan) {
+			uint32 tail = MIN(size - kFingerprintSpan, kFingerprintSpan);
+			f.seek(size - tail);
+			length += f.read(data + length, tail);
+		}
+
+		fingerprint[2 * i] = size;
+		fingerprint[2 * i + 1] = cacheChecksum(data, length);
+	}
+}
+
+static void writeCharacter(Common::WriteStream &s, const Character &c) {
+	s.writeSint32LE(c._id);
+	s.write(c._name, sizeof(c._name));
+	s.writeSint32LE(c._xtend);
+	s.writeSint32LE(c._type);
+	s.write(c._desc, sizeof(c._desc));
+	s.writeSint32LE(c._proc);
+	s.writeSint32LE(c._locationId);
+	s.writeSint32LE(c._box);
+	s.writeSint32LE(c._data5);
+	s.writeSint32LE(c._data6);
+	s.writeSint32LE(c._data7);
+	s.writeSint32LE(c._data8);
+	s.writeSint32LE(c._isMortal);
+	s.writeSint32LE(c._hitPoints);
+	s.writeSint32LE(c._hitPointsMax);
+	s.writeSint32LE(c._strength);
+	s.writeSint32LE(c._defense);
+	s.writeSint32LE(c._minDamage);
+	s.writeSint32LE(c._maxDamage);
+	s.writeSint32LE(c._data14);
+	s.writeSint32LE(c._data15);
+	s.writeSint32LE(c._data16);
+	s.writeSint32LE(c._spellPoints);
+	s.writeSint32LE(c._spellPointsMax);
+	s.writeSint16LE(c._destLoc);
+	s.writeSint16LE(c._destBox);
+
+	// From the .scp file
+	for (uint i = 0; i < ARRAYSIZE(c._scopes); ++i) {
+		s.writeSint16LE(c._scopes[i].minFrame);
+		s.writeSint16LE(c._scopes[i].maxFrame);
+		s.writeSint16LE(c._scopes[i].startFrame);
+	}
+	s.writeUint16LE(c._walkSpeed);
+	s.writeUint16LE(c._animSpeed);
+	s.writeByte(c._stopped);
+	s.writeUint16LE(c._timeout);
+	s.writeSint32LE(c._offset78);
+	s.writeSint32LE(c._lastLocation);
+	s.writeSint32LE(c._lastBox);
+	s.writeSint32LE(c._start3);
+	s.writeSint32LE(c._start4);
+	s.writeSint32LE(c._start5);
+}
+
+static void readCharacter(Common::ReadStream &s, Character &c) {
+	c._id = s.readSint32LE();
+	s.read(c._name, sizeof(c._name));
+	c._xtend = s.readSint32LE();
+	c._type = s.readSint32LE();
+	s.read(c._desc, sizeof(c._desc));
+	c._proc = s.readSint32LE();
+	c._locationId = s.readSint32LE();
+	c._box = s.readSint32LE();
+	c._data5 = s.readSint32LE();
+	c._data6 = s.readSint32LE();
+	c._data7 = s.readSint32LE();
+	c._data8 = s.readSint32LE();
+	c._isMortal = s.readSint32LE();
+	c._hitPoints = s.readSint32LE();
+	c._hitPointsMax = s.readSint32LE();
+	c._strength = s.readSint32LE();
+	c._defense = s.readSint32LE();
+	c._minDamage = s.readSint32LE();
+	c._maxDamage = s.readSint32LE();
+	c._data14 = s.readSint32LE();
+	c._data15 = s.readSint32LE();
+	c._data16 = s.readSint32LE();
+	c._spellPoints = s.readSint32LE();
+	c._spellPointsMax = s.readSint32LE();
+	c._destLoc = s.readSint16LE();
+	c._destBox = s.readSint16LE();
+
+	for (uint i = 0; i < ARRAYSIZE(c._scopes); ++i) {
+		c._scopes[i].minFrame = s.readSint16LE();
+		c._scopes[i].maxFrame = s.readSint16LE();
+		c._scopes[i].startFrame = s.readSint16LE();
+	}
+	c._walkSpeed = s.readUint16LE();
+	c._animSpeed = s.readUint16LE();
+	c._stopped = s.readByte() != 0;
+	c._timeout = s.readUint16LE();
+	c._offset78 = s.readSint32LE();
+	c._lastLocation = s.readSint32LE();
+	c._lastBox = s.readSint32LE();
+	c._start3 = s.readSint32LE();
+	c._start4 = s.readSint32LE();
+	c._start5 = s.readSint32LE();
+
+	// Same derived values initScopes() sets for START
+	c._gotoLoc = c._lastLocation;
+	c._gotoBox = c._lastBox;
+	c._screenX = c._gotoX = c._start3 / 256;
+	c._screenY = c._gotoY = c._start4 / 256;
+	c._start3Prev = c._start3PrevPrev = c._start3;
+	c._start4Prev = c._start4PrevPrev = c._start4;
+	c._start5Prev = c._start5PrevPrev = c._start5;
+}
+
+Common::String Database::getCacheName() const {
+	return Common::String::format("%s-%s.dbc", _vm->getTargetName().c_str(), _databasePrefix.c_str());
+}
+
+/**
+ * Loads the tables built by initLocations() through initRoutes() from the
+ * binary image written by saveCache(). Returns false if there is no usable
+ * cache, in which case nothing is left allocated.
+ */
+bool Database::loadCache() {
+	Common::InSaveFile *in = _vm->getSaveFileManager()->openForLoading(getCacheName());
+	if (!in)
+		return false;
+
+	uint32 tag = in->readUint32BE();
+	uint32 version = in->readUint32LE();
+	uint32 size = in->readUint32LE();
+	uint32 checksum = in->readUint32LE();
+
+	if (in->err() || in->eos() || tag != MKTAG('K','O','M','D') || version != kCacheVersion ||
+		size != (uint32)in->size() - kCacheHeaderSize) {
+		delete in;
+		return false;
+	}
+
+	uint32 fingerprint[2 * kCacheSourcesNum];
+	getSourceFingerprint(fingerprint);
+
+	for (int i = 0; i < 2 * kCacheSourcesNum; ++i) {
+		if (in->readUint32LE() != fingerprint[i]) {
+			debug(1, "Database cache %s is out of date", getCacheName().c_str());
+			delete in;
+			return false;
+		}
+	}
+
+	byte *data = new byte[size];
+	bool valid = in->read(data, size) == size && cacheChecksum(data, size) == checksum;
+	delete in;
+
+	if (!valid) {
+		warning("Ignoring damaged database cache %s", getCacheName().c_str());
+		delete[] data;
+		return false;
+	}
+
+	Common::MemoryReadStream s(data, size, DisposeAfterUse::YES);
+
+	_locationsNum = s.readSint32LE();
+	_locations = new Location[_locationsNum];
+	for (int i = 0; i < _locationsNum; ++i) {
+		Location &loc = _locations[i];
+		s.read(loc.name, sizeof(loc.name));
+		loc.xtend = s.readSint32LE();
+		loc.allowedTime = s.readSint32LE();
+		s.read(loc.desc, sizeof(loc.desc));
+
+		uint32 eventsNum = s.readUint32LE();
+		for (uint32 j = 0; j < eventsNum && !s.eos(); ++j) {
+			EventLink ev;
+			ev.exitBox = s.readSint32LE();
+			ev.proc = s.readSint32LE();
+			loc.events.push_back(ev);
+		}
+	}
+
+	_charactersNum = s.readSint32LE();
+	_characters = new Character[_charactersNum];
+	for (int i = 0; i < _charactersNum; ++i)
+		readCharacter(s, _characters[i]);
+
+	_objectsNum = s.readSint32LE();
+	_objects = new Object[_objectsNum];
+	for (int i = 0; i < _objectsNum; ++i) {
+		Object &obj = _objects[i];
+		s.read(obj.name, sizeof(obj.name));
+		obj.data1 = s.readSint32LE();
+		s.read(obj.desc, sizeof(obj.desc));
+		obj.type = s.readSint32LE();
+		obj.spellType = s.readSint32LE();
+		obj.proc = s.readSint32LE();
+		obj.data4 = s.readSint32LE();
+		obj.isCarryable = s.readSint32LE();
+		obj.isContainer = s.readSint32LE();
+		obj.isVisible = s.readSint32LE();
+		obj.isSprite = s.readSint32LE();
+		obj.isUseImmediate = s.readSint32LE();
+		obj.isPickable = s.readSint32LE();
+		obj.isUsable = s.readSint32LE();
+		obj.price = s.readSint32LE();
+		obj.data11 = s.readSint32LE();
+		obj.spellCost = s.readSint32LE();
+		obj.minDamage = s.readSint32LE();
+		obj.maxDamage = s.readSint32LE();
+		obj.ownerType = s.readSint32LE();
+		obj.ownerId = s.readSint32LE();
+		obj.box = s.readSint32LE();
+		obj.data16 = s.readSint32LE();
+		obj.data17 = s.readSint32LE();
+		obj.data18 = s.readSint32LE();
+	}
+
+	_varSize = s.readSint32LE();
+	_variables = (int16 *)calloc(_varSize, sizeof(_variables[0]));
+
+	_procsNum = s.readSint32LE();
+	_processes = new Process[_procsNum];
+	for (int i = 0; i < _procsNum; ++i) {
+		s.read(_processes[i].name, sizeof(_processes[i].name));
+
+		uint32 commandsNum = s.readUint32LE();
+		for (uint32 j = 0; j < commandsNum && !s.eos(); ++j) {
+			Command cmdObject;
+			cmdObject.cmd = s.readSint32LE();
+			cmdObject.value = s.readUint16LE();
+			cmdObject.code = s.readUint32LE();
+			cmdObject.codeSize = s.readUint32LE();
+			_processes[i].commands.push_back(cmdObject);
+		}
+	}
+
+	uint32 codeSize = s.readUint32LE();
+	_code.resize(codeSize);
+	for (uint32 i = 0; i < codeSize && !s.eos(); ++i) {
+		_code[i].opcode = s.readUint16LE();
+		_code[i].arg1 = s.readSint16LE();
+		_code[i].arg2 = s.readSint32LE();
+		_code[i].arg3 = s.readSint32LE();
+		_code[i].arg4 = s.readSint32LE();
+		_code[i].arg5 = s.readSint32LE();
+		_code[i].arg6 = s.readSint32LE();
+	}
+
+	uint32 stringsNum = s.readUint32LE();
+	for (uint32 i = 0; i < stringsNum && !s.eos(); ++i) {
+		byte len = s.readByte();
+		char str[256];
+		s.read(str, len);
+		_strings.push_back(Common::String(str, len));
+	}
+
+	_routesSize = s.readSint32LE();
+	_routes = new byte[_routesSize];
+	s.read(_routes, _routesSize);
+
+	_mapSize = s.readSint32LE();
+	_map = new byte[_mapSize];
+	s.read(_map, _mapSize);
+
+	_locRoutes = new LocRoute[_locRoutesSize];
+	for (int i = 0; i < _locRoutesSize; ++i) {
+		for (int j = 0; j < 6; ++j) {
+			Exit &exit = _locRoutes[i].exits[j];
+			exit.exit = s.readSint16LE();
+			exit.exitLoc = s.readSint16LE();
+			exit.exitBox = s.readSint16LE();
+		}
+
+		for (int j = 0; j < 32; ++j) {
+			Box &box = _locRoutes[i].boxes[j];
+			box.enabled = s.readByte() != 0;
+			box.x1 = s.readSint16LE();
+			box.y1 = s.readSint16LE();
+			box.x2 = s.readSint16LE();
+			box.y2 = s.readSint16LE();
+			box.priority = s.readSint16LE();
+			box.z1 = s.readSint32LE();
+			box.z2 = s.readSint32LE();
+			box.attrib = s.readByte();
+			s.read(box.joins, sizeof(box.joins));
+		}
+	}
+
+	if (s.err() || s.eos() || s.pos() != s.size()) {
+		warning("Ignoring inconsistent database cache %s", getCacheName().c_str());
+
+		delete[] _locations;
+		delete[] _characters;
+		delete[] _objects;
+		free(_variables);
+		delete[] _processes;
+		delete[] _routes;
+		delete[] _map;
+		delete[] _locRoutes;
+		_locations = 0;
+		_characters = 0;
+		_objects = 0;
+		_variables = 0;
+		_processes = 0;
+		_routes = 0;
+		_map = 0;
+		_locRoutes = 0;
+		_code.clear();
+		_strings.clear();
+
+		return false;
+	}
+
+	debug(1, "Loaded database cache %s", getCacheName().c_str());
+	return true;
+}
+
+/**
+ * Writes the freshly parsed tables so that the next startup can skip the
+ * text parsers. Must be called before any script has run.
+ */
+void Database::saveCache() {
+	Common::MemoryWriteStreamDynamic s(DisposeAfterUse::YES);
+
+	s.writeSint32LE(_locationsNum);
+	for (int i = 0; i < _locationsNum; ++i) {
+		const Location &loc = _locations[i];
+		s.write(loc.name, sizeof(loc.name));
+		s.writeSint32LE(loc.xtend);
+		s.writeSint32LE(loc.allowedTime);
+		s.write(loc.desc, sizeof(loc.desc));
+
+		s.writeUint32LE(loc.events.size());
+		for (Common::List<EventLink>::const_iterator j = loc.events.begin(); j != loc.events.end(); ++j) {
+			s.writeSint32LE(j->exitBox);
+			s.writeSint32LE(j->proc);
+		}
+	}
+
+	s.writeSint32LE(_charactersNum);
+	for (int i = 0; i < _charactersNum; ++i)
+		writeCharacter(s, _characters[i]);
+
+	s.writeSint32LE(_objectsNum);
+	for (int i = 0; i < _objectsNum; ++i) {
+		const Object &obj = _objects[i];
+		s.write(obj.name, sizeof(obj.name));
+		s.writeSint32LE(obj.data1);
+		s.write(obj.desc, sizeof(obj.desc));
+		s.writeSint32LE(obj.type);
+		s.writeSint32LE(obj.spellType);
+		s.writeSint32LE(obj.proc);
+		s.writeSint32LE(obj.data4);
+		s.writeSint32LE(obj.isCarryable);
+		s.writeSint32LE(obj.isContainer);
+		s.writeSint32LE(obj.isVisible);
+		s.writeSint32LE(obj.isSprite);
+		s.writeSint32LE(obj.isUseImmediate);
+		s.writeSint32LE(obj.isPickable);
+		s.writeSint32LE(obj.isUsable);
+		s.writeSint32LE(obj.price);
+		s.writeSint32LE(obj.data11);
+		s.writeSint32LE(obj.spellCost);
+		s.writeSint32LE(obj.minDamage);
+		s.writeSint32LE(obj.maxDamage);
+		s.writeSint32LE(obj.ownerType);
+		s.writeSint32LE(obj.ownerId);
+		s.writeSint32LE(obj.box);
+		s.writeSint32LE(obj.data16);
+		s.writeSint32LE(obj.data17);
+		s.writeSint32LE(obj.data18);
+	}
+
+	s.writeSint32LE(_varSize);
+
+	s.writeSint32LE(_procsNum);
+	for (int i = 0; i < _procsNum; ++i) {
+		s.write(_processes[i].name, sizeof(_processes[i].name));
+
+		s.writeUint32LE(_processes[i].commands.size());
+		for (Common::Array<Command>::const_iterator j = _processes[i].commands.begin();
+				j != _processes[i].commands.end(); ++j) {
+			s.writeSint32LE(j->cmd);
+			s.writeUint16LE(j->value);
+			s.writeUint32LE(j->code);
+			s.writeUint32LE(j->codeSize);
+		}
+	}
+
+	s.writeUint32LE(_code.size());
+	for (uint i = 0; i < _code.size(); ++i) {
+		s.writeUint16LE(_code[i].opcode);
+		s.writeSint16LE(_code[i].arg1);
+		s.writeSint32LE(_code[i].arg2);
+		s.writeSint32LE(_code[i].arg3);
+		s.writeSint32LE(_code[i].arg4);
+		s.writeSint32LE(_code[i].arg5);
+		s.writeSint32LE(_code[i].arg6);
+	}
+
+	// Strings come from the 30-byte OpCode::arg1, so a length byte is enough
+	s.writeUint32LE(_strings.size());
+	for (uint i = 0; i < _strings.size(); ++i) {
+		s.writeByte(_strings[i].size());
+		s.write(_strings[i].c_str(), _strings[i].size());
+	}
+
+	s.writeSint32LE(_routesSize);
+	s.write(_routes, _routesSize);
+
+	s.writeSint32LE(_mapSize);
+	s.write(_map, _mapSize);
+
+	for (int i = 0; i < _locRoutesSize; ++i) {
+		for (int j = 0; j < 6; ++j) {
+			const Exit &exit = _locRoutes[i].exits[j];
+			s.writeSint16LE(exit.exit);
+			s.writeSint16LE(exit.exitLoc);
+			s.writeSint16LE(exit.exitBox);
+		}
+
+		for (int j = 0; j < 32; ++j) {
+			const Box &box = _locRoutes[i].boxes[j];
+			s.writeByte(box.enabled);
+			s.writeSint16LE(box.x1);
+			s.writeSint16LE(box.y1);
+			s.writeSint16LE(box.x2);
+			s.writeSint16LE(box.y2);
+			s.writeSint16LE(box.priority);
+			s.writeSint32LE(box.z1);
+			s.writeSint32LE(box.z2);
+			s.writeByte(box.attrib);
+			s.write(box.joins, sizeof(box.joins));
+		}
+	}
+
+	Common::OutSaveFile *out = _vm->getSaveFileManager()->openForSaving(getCacheName(), false);
+	if (!out) {
+		warning("Can't create database cache %s", getCacheName().c_str());
+		return;
+	}
+
+	out->writeUint32BE(MKTAG('K','O','M','D'));
+	out->writeUint32LE(kCacheVersion);
+	out->writeUint32LE(s.size());
+	out->writeUint32LE(cacheChecksum(s.getData(), s.size()));
+
+	uint32 fingerprint[2 * kCacheSourcesNum];
+	getSourceFingerprint(fingerprint);
+	for (int i = 0; i < 2 * kCacheSourcesNum; ++i)
+		out->writeUint32LE(fingerprint[i]);
+
+	out->write(s.getData(), s.size());
+	out->finalize();
+
+	if (out->err())
+		warning("Can't write database cache %s", getCacheName().c_str());
+
+	delete out;
+}
+
 int8 Database::box2box(int loc, int fromBox, int toBox) {
-	uint32 locOffset;
+	const byte *table;
 
 	if ((loc | fromBox | toBox) > 127)
 		return -1;
 
-	locOffset = READ_LE_UINT32(_map + loc * 4);
-	return (int8)(_map[locOffset + *(int8*)(_map + locOffset) * toBox + fromBox + 1]);
+	if (loc >= 0 && _boxRoutes[loc])
+		table = _boxRoutes[loc];
+	else
+		table = _map + READ_LE_UINT32(_map + loc * 4);
+
+	return (int8)(table[*(const int8 *)table * toBox + fromBox + 1]);
+}
+
+/**
+ * Number of box2box() hops it takes to get from one box to another.
+ */
+int Database::boxDistance(int loc, int fromBox, int toBox) {
+	if (loc >= 0 && loc < _locRoutesSize && fromBox >= 0 && fromBox < 32 && toBox >= 0 && toBox < 32) {
+		int8 distance = _boxDistances[(loc * 32 + toBox) * 32 + fromBox];
+		if (distance >= 0)
+			return distance;
+	}
+
+	int currBox = fromBox;
+	int distance = 0;
+	while (1) {
+		currBox = box2box(loc, currBox, toBox);
+		if (currBox == -1)
+			break;
+		distance++;
+	}
+
+	return distance;
+}
+
+/**
+ * Number of loc2loc() hops it takes to get from one location to another.
+ */
+int Database::locDistance(int fromLoc, int toLoc) {
+	if (fromLoc >= 0 && fromLoc < _locDistancesNum && toLoc >= 0 && toLoc < _locDistancesNum) {
+		uint8 distance = _locDistances[toLoc * _locDistancesNum + fromLoc];
+		if (distance != kUnknownLocDistance)
+			return distance;
+	}
+
+	int currLoc = fromLoc;
+	int distance = 0;
+	while (distance < kMaxRouteHops) {
+		currLoc = loc2loc(currLoc, toLoc);
+		if (currLoc == -1)
+			break;
+		distance++;
+	}
+
+	return distance;
 }
 
 int8 Database::whatBox(int locId, int x, int y) {
 	Box *boxes = _locRoutes[locId].boxes;
+	uint32 candidates = 0xFFFFFFFF;
 
-	for (int i = 0; i < 32; ++i)
-		if (boxes[i].enabled &&
+	if (inBoxGrid(x, y))
+		candidates = _boxGrids[locId].cells[y / kBoxGridCellSize][x / kBoxGridCellSize] &
+			_boxGrids[locId].walkable;
+
+	for (int i = 0; candidates != 0; ++i, candidates >>= 1)
+		if ((candidates & 1) &&
+			boxes[i].enabled &&
 			!(boxes[i].attrib & 6) &&
 			x >= boxes[i].x1 &&
 			x <= boxes[i].x2 &&
@@ -921,6 +1890,15 @@ int8 Database::whatBox(int locId, int x, int y) {
 int8 Database::whatBoxLinked(int locId, int8 boxId, int x, int y) {
 	Box *box = &(_locRoutes[locId].boxes[boxId]);
 
+	// None of the box or its joins can contain the point
+	if (boxId >= 0 && boxId < 32 && inBoxGrid(x, y)) {
+		const BoxGrid *grid = &_boxGrids[locId];
+		uint32 cell = grid->cells[y / kBoxGridCellSize][x / kBoxGridCellSize] | grid->disabled;
+
+		if ((grid->links[boxId] & grid->linkable & cell) == 0)
+			return -1;
+	}
+
 	if ((box->attrib & 14) == 0 &&
 		x >= box->x1 && x <= box->x2 &&
 		y >= box->y1 && y <= box->y2) {
@@ -1000,6 +1978,9 @@ int16 Database::getZValue(int loc, int box, int32 y) {
 }
 
 uint16 Database::getExitBox(int currLoc, int nextLoc) {
+	if (currLoc >= 0 && currLoc < _locRoutesSize && nextLoc >= 0 && nextLoc < 128)
+		return _exitBoxes[currLoc * 128 + nextLoc];
+
 	for (int i = 0; i < 6; ++i)
 		if (_locRoutes[currLoc].exits[i].exitLoc == nextLoc)
 			return _locRoutes[currLoc].exits[i].exit;
@@ -1040,14 +2021,7 @@ int Database::findFarthestExit(int loc, int box) {
 		if (!boxPtr->enabled || boxPtr->attrib != 1)
 			continue;
 
-		int currBox = i;
-		int distance = 0;
-		while (1) {
-			currBox = box2box(loc, currBox, box);
-			if (currBox == -1)
-				break;
-			distance++;
-		}
+		int distance = boxDistance(loc, i, box);
 		if (distance >= farthestDistance) {
 			farthestDistance = distance;
 			resBox = i;
@@ -1076,7 +2050,19 @@ void Database::getClosestBox(int loc, uint16 mouseX, uint16 mouseY,
 	int tmp4 = 639;
 	int tmp4Box = -1;
 
-	for (int i = 0; i < 32; ++i) {
+	// Only floor boxes overlapping the mouse column or the character row matter
+	uint32 colBoxes = 0xFFFFFFFF;
+	uint32 rowBoxes = 0xFFFFFFFF;
+
+	if (mouseX < kBoxGridCols * kBoxGridCellSize)
+		colBoxes = _boxGrids[loc].cols[mouseX / kBoxGridCellSize] & _boxGrids[loc].floor;
+	if (screenY >= 0 && screenY < kBoxGridRows * kBoxGridCellSize)
+		rowBoxes = _boxGrids[loc].rows[screenY / kBoxGridCellSize] & _boxGrids[loc].floor;
+
+	for (int i = 0; colBoxes != 0; ++i, colBoxes >>= 1) {
+		if (!(colBoxes & 1))
+			continue;
+
 		Box *box = getBox(loc, i);
 		if (!box->enabled)
 			continue;
@@ -1096,7 +2082,10 @@ void Database::getClosestBox(int loc, uint16 mouseX, uint16 mouseY,
 	}
 
 	if (tmpBox == -1 && tmp2Box == -1) {
-		for (int i = 0; i < 32; ++i) {
+		for (int i = 0; rowBoxes != 0; ++i, rowBoxes >>= 1) {
+			if (!(rowBoxes & 1))
+				continue;
+
 			Box *box = getBox(loc, i);
 			if (!box->enabled)
 				continue;
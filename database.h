@@ -28,6 +28,7 @@
 #include "common/str.h"
 #include "common/path.h"
 #include "common/list.h"
+#include "common/array.h"
 #include "common/file.h"
 
 #include "kom/character.h"
@@ -35,6 +36,7 @@
 namespace Kom {
 
 class KomEngine;
+class ConvCache;
 
 struct EventLink {
 	int exitBox;
@@ -97,16 +99,35 @@ struct OpCode {
 	OpCode() : arg2(0), arg3(0), arg4(0), arg5(0), arg6(0) { arg1[0] = '\0'; }
 };
 
+/**
+ * Compiled form of an OpCode, as executed by Game::doStat().
+ * arg1 indexes the database string pool, or is -1 if there is no string.
+ */
+struct Instruction {
+	uint16 opcode;
+	int16 arg1;
+	int32 arg2;
+	int32 arg3;
+	int32 arg4;
+	int32 arg5;
+	int32 arg6;
+};
+
 struct Command {
 	int cmd;
 	uint16 value;
-	Common::List<OpCode> opcodes;
-	Command() : value(0) {}
+	Common::List<OpCode> opcodes; // Only used while parsing, see compileProcs()
+	uint32 code;
+	uint32 codeSize;
+	Command() : value(0), code(0), codeSize(0) {}
 };
 
 struct Process {
 	char name[30];
-	Common::List<Command> commands;
+	Common::Array<Command> commands;
+
+	// Start of the commands handling each of cmd 312-324, see Database::indexProcs()
+	uint16 cmdIndex[14];
 };
 
 struct Exit {
@@ -129,6 +150,27 @@ struct LocRoute {
 	Box boxes[32];
 };
 
+enum {
+	kBoxGridCellSize = 32,
+	kBoxGridCols = 640 / kBoxGridCellSize,
+	kBoxGridRows = (400 + kBoxGridCellSize - 1) / kBoxGridCellSize
+};
+
+/**
+ * Bitmasks of the boxes of one location, used to narrow down point
+ * queries. Bit n stands for box n.
+ */
+struct BoxGrid {
+	uint32 cells[kBoxGridRows][kBoxGridCols]; // Enabled boxes touching each cell
+	uint32 cols[kBoxGridCols];                // ...each column of cells
+	uint32 rows[kBoxGridRows];                // ...each row of cells
+	uint32 walkable;                          // Enabled, (attrib & 6) == 0
+	uint32 floor;                             // Enabled, attrib == 0
+	uint32 linkable;                          // (attrib & 14) == 0
+	uint32 disabled;
+	uint32 links[32];                         // Each box and its joins
+};
+
 class Database {
 public:
 	Database(KomEngine *vm);
@@ -140,6 +182,8 @@ public:
 
 	int8 loc2loc(int from, int to) { return (int8)(_routes[(int8)(_routes[0]) * to + from + 1]); }
 	int8 box2box(int loc, int fromBox, int toBox);
+	int boxDistance(int loc, int fromBox, int toBox);
+	int locDistance(int fromLoc, int toLoc);
 
 	Box *getBox(int locId, int boxId) const { return &(_locRoutes[locId].boxes[boxId]); }
 	Exit *getExits(int locId) const { return _locRoutes[locId].exits; }
@@ -167,6 +211,12 @@ public:
 	void setCharPos(int charId, int loc, int box);
 	bool giveObject(int obj, int charId, bool noAnimation = false);
 
+	const Instruction *getCode(uint32 index) const { return &_code[index]; }
+	const char *getString(int16 index) const { return index < 0 ? "" : _strings[index].c_str(); }
+
+	const Command *findCommands(const Process *proc, int cmd, uint *count) const;
+	const Command *findCommands(const Process *proc, int cmd, int value, uint *count) const;
+
 	Process *getProc(uint16 procIndex) const { return procIndex < _procsNum ? &(_processes[procIndex]) : NULL; }
 	Character *getChar(uint16 charIndex) const { return charIndex < _charactersNum ? &(_characters[charIndex]) : NULL; }
 	Character *getMagicChar(uint16 charIndex) { return charIndex < sizeof(_magicCharacters) ? &(_magicCharacters[charIndex]) : NULL; }
@@ -182,6 +232,7 @@ public:
 
 	byte *getConvIndex(const char *entry);
 	Common::File *getConvData() { return _convData; }
+	ConvCache *convCache() { return _convCache; }
 
 private:
 	void loadConvIndex();
@@ -193,9 +244,18 @@ private:
 	void initObjectLocs();
 	void initCharacterLocs();
 	void initProcs();
+	void compileProcs();
+	void indexProcs();
 	void initRoutes();
+	void initRouteTables();
+	void initBoxGrids();
 	void initScopes();
 
+	Common::String getCacheName() const;
+	void getSourceFingerprint(uint32 *fingerprint) const;
+	bool loadCache();
+	void saveCache();
+
 	KomEngine *_vm;
 
 	Common::String _databasePrefix;
@@ -215,15 +275,21 @@ private:
 	Process *_processes;
 	int _procsNum;
 
+	Common::Array<Instruction> _code;
+	Common::Array<Common::String> _strings;
+
 	int _varSize;
 	int16 *_variables;
 
 	uint32 _convIndexLen;
 	byte *_convIndex;
+	Common::Array<uint32> _convSorted;
 	Common::File *_convData;
+	ConvCache *_convCache;
 
 	int _narrIndexSize;
 	byte *_narrIndex;
+	Common::Array<uint32> _narrSorted;
 	Common::File _narrData;
 
 	int _mapSize;
@@ -234,6 +300,14 @@ private:
 
 	static const int _locRoutesSize;
 	LocRoute *_locRoutes;
+
+	// Derived from the above by initRouteTables()
+	const byte *_boxRoutes[128];
+	int8 *_boxDistances;
+	int _locDistancesNum;
+	uint8 *_locDistances;
+	uint16 *_exitBoxes;
+	BoxGrid *_boxGrids;
 };
 } // End of namespace Kom
 
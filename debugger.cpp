@@ -21,6 +21,7 @@
  */
 
 #include <stdlib.h>
+#include <string.h>
 #include "common/list.h"
 #include "gui/debugger.h"
 
@@ -29,6 +30,7 @@
 #include "kom/database.h"
 #include "kom/game.h"
 #include "kom/character.h"
+#include "kom/screen.h"
 
 namespace Kom {
 
@@ -41,6 +43,7 @@ Debugger::Debugger(KomEngine *vm) : GUI::Debugger(), _vm(vm) {
 	registerCmd("day", WRAP_METHOD(Debugger, cmdDay));
 	registerCmd("night", WRAP_METHOD(Debugger, cmdNight));
 	registerCmd("gold", WRAP_METHOD(Debugger, cmdGold));
+	registerCmd("frames", WRAP_METHOD(Debugger, cmdFrames));
 }
 
 bool Debugger::cmdRoom(int argc, const char **argv) {
@@ -94,12 +97,15 @@ bool Debugger::cmdProc(int argc, const char **argv) {
 
 		debugPrintf("Process name is %s\n", proc->name);
 
-		for (Common::List<Command>::iterator i = proc->commands.begin(); i != proc->commands.end(); ++i) {
+		Database *db = _vm->database();
+
+		for (Common::Array<Command>::iterator i = proc->commands.begin(); i != proc->commands.end(); ++i) {
 			debugPrintf("- Command %d - value %hd\n", i->cmd, i->value);
 
-			for (Common::List<OpCode>::iterator j = i->opcodes.begin(); j != i->opcodes.end(); ++j) {
+			const Instruction *j = db->getCode(i->code);
+			for (uint32 n = 0; n < i->codeSize; ++n, ++j) {
 				debugPrintf("|- Opcode %d - (%s, %d, %d, %d, %d, %d)\n", j->opcode,
-						j->arg1, j->arg2, j->arg3, j->arg4, j->arg5, j->arg6);
+						db->getString(j->arg1), j->arg2, j->arg3, j->arg4, j->arg5, j->arg6);
 			}
 		}
 	}
@@ -150,4 +156,22 @@ bool Debugger::cmdGold(int argc, const char **argv) {
 	return false;
 }
 
+bool Debugger::cmdFrames(int argc, const char **argv) {
+	if (argc == 2 && strcmp(argv[1], "reset") == 0) {
+		_vm->screen()->resetFrameStats();
+		return true;
+	}
+
+	const FrameStats &stats = _vm->screen()->frameStats();
+
+	debugPrintf("Frames: %u, late: %u\n", stats.frames, stats.lateFrames);
+	if (stats.frames > 0)
+		debugPrintf("Work per frame: avg %u ms, max %u ms\n",
+			stats.totalWork / stats.frames, stats.maxWork);
+	debugPrintf("Max lateness: %u ms\n", stats.maxLateness);
+	debugPrintf("Use 'frames reset' to clear the statistics\n");
+
+	return true;
+}
+
 } // End of namespace Kom
@@ -42,6 +42,7 @@ protected:
 	bool cmdDay(int argc, const char **argv);
 	bool cmdNight(int argc, const char **argv);
 	bool cmdGold(int argc, const char **argv);
+	bool cmdFrames(int argc, const char **argv);
 
 private:
 
@@ -20,6 +20,8 @@
  *
  */
 
+#include <string.h>
+
 #include "common/file.h"
 #include "common/endian.h"
 
@@ -28,6 +30,8 @@
 namespace Kom {
 
 Font::Font(const char *filename) : _data(0) {
+	memset(_rasterized, 0, sizeof(_rasterized));
+
 	Common::File f;
 	f.open(filename);
 	_data = new byte[f.size()];
@@ -44,4 +48,45 @@ const byte *Font::getCharData(char c) {
 	return _data + offset;
 }
 
+const Glyph *Font::getGlyph(char c) {
+	Glyph *glyph = &_glyphs[(uint8)c];
+
+	if (!_rasterized[(uint8)c]) {
+		rasterize(glyph, c);
+		_rasterized[(uint8)c] = true;
+	}
+
+	return glyph;
+}
+
+void Font::rasterize(Glyph *glyph, char c) {
+	const byte *data = getCharData(c);
+	uint8 width = *data++;
+	int embossPitch = width + 2;
+
+	glyph->width = width;
+	glyph->mask = new byte[width * 8]();
+	glyph->emboss = new byte[embossPitch * 10]();
+
+	// Columns are stored one after another. The shadow pixels are set in
+	// the same order as Screen::writeTextStyle() used to, since they
+	// overwrite each other.
+	for (uint w = 0; w < width; ++w) {
+		for (uint h = 0; h < 8; ++h) {
+			if (*data++ == 0)
+				continue;
+
+			glyph->mask[h * width + w] = 1;
+
+			byte *e = glyph->emboss + (h + 1) * embossPitch + w + 1;
+			e[-1] = 3;
+			e[-embossPitch] = 3;
+			e[-embossPitch - 1] = 3;
+			e[1] = 53;
+			e[embossPitch] = 53;
+			e[embossPitch + 1] = 53;
+		}
+	}
+}
+
 } // End of namespace Kom
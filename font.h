@@ -27,6 +27,22 @@
 
 namespace Kom {
 
+/**
+ * A character of the font, rasterized from its packed column data.
+ * mask is width x 8 pixels, row by row, non-zero where the character is
+ * drawn. emboss is (width + 2) x 10 pixels, starting one pixel above and
+ * to the left of the character, holding the shadow colors of the
+ * embossed style, or 0 where nothing is drawn.
+ */
+struct Glyph {
+	Glyph() : width(0), mask(0), emboss(0) {}
+	~Glyph() { delete[] mask; delete[] emboss; }
+
+	uint8 width;
+	byte *mask;
+	byte *emboss;
+};
+
 class Font {
 public:
 
@@ -34,10 +50,16 @@ public:
 	~Font();
 
 	const byte *getCharData(char c);
+	const Glyph *getGlyph(char c);
+	uint8 getCharWidth(char c) { return getGlyph(c)->width; }
 
 private:
 
+	void rasterize(Glyph *glyph, char c);
+
 	byte *_data;
+	Glyph _glyphs[256];
+	bool _rasterized[256];
 };
 
 } // End of namespace Kom
@@ -349,12 +349,12 @@ void Game::processChar(int proc) {
 	bool stop = false;
 	Process *p = _vm->database()->getProc(proc);
 
-	for (Common::List<Command>::iterator i = p->commands.begin();
-			i != p->commands.end() && !stop; ++i) {
-		if (i->cmd == 313) { // Character
-			debug(5, "Processing char in %s", p->name);
-			stop = doStat(&(*i));
-		}
+	uint count;
+	const Command *cmds = _vm->database()->findCommands(p, 313, &count); // Character
+
+	for (uint i = 0; i < count && !stop; ++i) {
+		debug(5, "Processing char in %s", p->name);
+		stop = doStat(&cmds[i]);
 	}
 }
 
@@ -392,45 +392,51 @@ bool Game::doProc(int command, int type, int id, int type2, int id2) {
 	if (command == 319 || command == 320 || command == 321)
 		foundUse = false;
 
-	Common::List<Command>::iterator i;
-	for (i = p->commands.begin(); i != p->commands.end(); ++i) {
-		if (i->cmd == command) {
-			switch (command) {
-			case 316: // Look at
-				foundLook = true;
-				if(doStat(&(*i)))
-					return true;
-				break;
-			case 317: // Fight
-				foundFight = true;
-				if(doStat(&(*i)))
-					return true;
-				break;
-			case 314: // Talk to
-			case 315: // Pick up
-			case 318: // Enter room
-			case 323: // Collide
-			case 324: // Reply
-				if(doStat(&(*i)))
-					return true;
-				break;
-			case 319: // Use
-				foundUse = true;
-				if(doStat(&(*i)))
-					return true;
-				break;
-			case 320: // Use item
-			case 321:
-				if (id2 == i->value) {
-					foundUse = true;
-					if(doStat(&(*i)))
-						return true;
-				}
-				break;
-			default:
-				warning("Unhandled proc command: %d", command);
+	uint count;
+	const Command *cmds;
+
+	if (command == 320 || command == 321)
+		cmds = _vm->database()->findCommands(p, command, id2, &count);
+	else
+		cmds = _vm->database()->findCommands(p, command, &count);
+
+	for (uint n = 0; n < count; ++n) {
+		const Command *i = &cmds[n];
+
+		switch (command) {
+		case 316: // Look at
+			foundLook = true;
+			if(doStat(i))
 				return true;
-			}
+			break;
+		case 317: // Fight
+			foundFight = true;
+			if(doStat(i))
+				return true;
+			break;
+		case 314: // Talk to
+		case 315: // Pick up
+		case 318: // Enter room
+		case 323: // Collide
+		case 324: // Reply
+			if(doStat(i))
+				return true;
+			break;
+		case 319: // Use
+			foundUse = true;
+			if(doStat(i))
+				return true;
+			break;
+		case 320: // Use item
+		case 321:
+			// Only commands matching id2 were returned
+			foundUse = true;
+			if(doStat(i))
+				return true;
+			break;
+		default:
+			warning("Unhandled proc command: %d", command);
+			return true;
 		}
 	}
 
@@ -438,9 +444,9 @@ bool Game::doProc(int command, int type, int id, int type2, int id2) {
 		return foundFight;
 	} else if (command == 316) {
 		return foundLook;
-	} else if (i == p->commands.end() && !foundUse) {
+	} else if (!foundUse) {
 		return false;
-	} else if (i == p->commands.end() && command == 319) {
+	} else if (command == 319) {
 		if (_vm->database()->getObj(id)->type == 2)
 			return false;
 		else
@@ -458,8 +464,10 @@ bool Game::doStat(const Command *cmd) {
 
 	debug(5, "Trying to execute Command %d - value %hd", cmd->cmd, cmd->value);
 
-	for (Common::List<OpCode>::const_iterator j = cmd->opcodes.begin();
-			j != cmd->opcodes.end() && keepProcessing; ++j) {
+	const Instruction *j = db->getCode(cmd->code);
+	const Instruction *end = j + cmd->codeSize;
+
+	for (; j != end && keepProcessing; ++j) {
 
 		if (_vm->shouldQuit())
 			break;
@@ -872,13 +880,13 @@ bool Game::doStat(const Command *cmd) {
 			db->setVar(j->arg2, db->getLoc(j->arg3)->xtend);
 			break;
 		case 467:
-			doActionPlayVideo(j->arg1);
+			doActionPlayVideo(db->getString(j->arg1));
 			break;
 		case 468:
-			doActionSpriteScene(j->arg1, j->arg2, j->arg3, j->arg4);
+			doActionSpriteScene(db->getString(j->arg1), j->arg2, j->arg3, j->arg4);
 			break;
 		case 469:
-			doActionPlaySample(j->arg1);
+			doActionPlaySample(db->getString(j->arg1));
 			break;
 		case 473:
 			db->getChar(0)->_start3 = db->getChar(0)->_start3PrevPrev;
@@ -897,14 +905,14 @@ bool Game::doStat(const Command *cmd) {
 			break;
 		case 474:
 			// Rejuvenate hit/spell points
-			if (strcmp(j->arg1, "REFRESH") == 0) {
+			if (strcmp(db->getString(j->arg1), "REFRESH") == 0) {
 				for (int i = 0; i < db->charactersNum(); ++i) {
 					Character *chr = db->getChar(i);
 					chr->_hitPoints = MIN(chr->_hitPoints + 5, chr->_hitPointsMax);
 					chr->_spellPoints = MIN(chr->_spellPoints + 5, chr->_spellPointsMax);
 				}
 			} else {
-				db->setVar(j->arg2, doExternalAction(j->arg1));
+				db->setVar(j->arg2, doExternalAction(db->getString(j->arg1)));
 			}
 			break;
 		case 475:
@@ -1046,7 +1054,7 @@ bool Game::doStat(const Command *cmd) {
 			break;
 		default:
 			warning("Unhandled OpCode: %d - (%s, %d, %d, %d, %d, %d)", j->opcode,
-				j->arg1, j->arg2, j->arg3, j->arg4, j->arg5, j->arg6);
+				db->getString(j->arg1), j->arg2, j->arg3, j->arg4, j->arg5, j->arg6);
 		}
 	}
 
@@ -1363,7 +1371,7 @@ void Game::loopMove() {
 				chr->stopChar();
 
 			if (chr->_spriteTimer <= 0 && chr->_fightPartner < 0)
-				chr->moveChar(true);
+				chr->moveCharSettled(true);
 			chr->moveCharOther();
 
 			if (chr->_gotoBox != chr->_lastBox) {
@@ -2368,12 +2376,13 @@ void Game::narratorStart(const char *filename, const char *codename) {
 		_vm->screen()->narratorScrollDelete();
 	}
 
+	_player.narratorSample.loadFile(filename);
+
 	text = _vm->database()->getNarratorText(codename);
 	if (text) {
-		_vm->screen()->narratorScrollInit(text);
+		_vm->screen()->narratorScrollInit(text, _player.narratorSample.getDuration());
 	}
 
-	_player.narratorSample.loadFile(filename);
 	_vm->sound()->playSampleSpeech(_player.narratorSample);
 }
 
@@ -100,9 +100,10 @@ KomEngine::KomEngine(OSystem *system)
 }
 
 KomEngine::~KomEngine() {
+	// Actors purge their scaled frames from the screen
+	delete _actorMan;
 	delete _screen;
 	delete _database;
-	delete _actorMan;
 	delete _input;
 	delete _sound;
 	delete _debugger;
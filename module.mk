@@ -6,6 +6,7 @@ MODULE_OBJS := \
 	character.o \
 	database.o \
 	actor.o \
+	blit.o \
 	input.o \
 	sound.o \
 	panel.o \
@@ -17,6 +18,18 @@ MODULE_OBJS := \
 	detection.o \
 	metaengine.o
 
+ifdef SCUMMVM_SSE2
+MODULE_OBJS += \
+	blit_sse2.o
+$(MODULE)/blit_sse2.o: CXXFLAGS += -msse2
+endif
+
+ifdef SCUMMVM_NEON
+MODULE_OBJS += \
+	blit_neon.o
+$(MODULE)/blit_neon.o: CXXFLAGS += $(NEON_CXXFLAGS)
+endif
+
 # This module can be built as a plugin
 ifeq ($(ENABLE_KOM), DYNAMIC_PLUGIN)
 PLUGIN := 1
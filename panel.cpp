@@ -35,9 +35,18 @@ using Common::String;
 
 namespace Kom {
 
+// Text rows of the panel lines. The original prints all text 4 pixels to
+// the right, so 6 is used as the column instead of 10 for the bottom two.
+enum {
+	kLocationRow = 3,
+	kActionRow = 12,
+	kHotspotRow = 22,
+	kTextCol = 6
+};
+
 Panel::Panel(KomEngine *vm, const char *filename) : _vm(vm),
 	_isEnabled(true), _isLoading(false), _suppressLoading(0),
-	_gotObjTime(0) {
+	_gotObjTime(0), _dirtyTop(0), _dirtyBottom(PANEL_H) {
 
 	File f;
 	f.open(filename);
@@ -62,32 +71,52 @@ Panel::~Panel() {
 
 void Panel::clear() {
 	memcpy(_panelBuf, _panelData, SCREEN_W * PANEL_H);
+	_dirtyTop = 0;
+	_dirtyBottom = PANEL_H;
+	_isDirty = true;
+}
+
+bool Panel::isDirty() const {
+	return _isDirty || !_gotObjects.empty() || _vm->screen()->isPanelOverdrawn();
+}
+
+/**
+ * Returns whether the embossed text line at row shares rows with the
+ * band being redrawn.
+ */
+bool Panel::isLineTouched(int row) const {
+	return row - 1 < _dirtyBottom && row + 9 > _dirtyTop;
 }
 
 void Panel::update() {
 	_isDirty = false;
 	enable(true);
-	clear();
 
-	// Draw texts
-	// FIXME - the location desc is fully centered, while the original prints it
-	//         4 pixels to the right.
-	// Actually, the original prints all text 4 pixels to the right, so we're using
-	// 6 as the column instead of 10 for the two bottom lines.
-	if (!_locationDesc.empty())
-		_vm->screen()->writeTextCentered(_panelBuf, _locationDesc.c_str(), 3, 31, true);
+	// Redraw the changed band. The shadows of neighbouring lines share a
+	// row, so every line touching the band is drawn again, in order.
+	if (_dirtyTop < _dirtyBottom) {
+		memcpy(_panelBuf + SCREEN_W * _dirtyTop, _panelData + SCREEN_W * _dirtyTop,
+			SCREEN_W * (_dirtyBottom - _dirtyTop));
 
-	if (!_actionDesc.empty())
-		_vm->screen()->writeText(_panelBuf, _actionDesc.c_str(), 12, 6, 31, true);
+		// FIXME - the location desc is fully centered, while the original prints it
+		//         4 pixels to the right.
+		if (!_locationDesc.empty() && isLineTouched(kLocationRow))
+			_vm->screen()->writeTextCentered(_panelBuf, _locationDesc.c_str(), kLocationRow, 31, true);
 
-	if (!_hotspotDesc.empty())
-		_vm->screen()->writeText(_panelBuf, _hotspotDesc.c_str(), 22, 6, 31, true);
+		if (!_actionDesc.empty() && isLineTouched(kActionRow))
+			_vm->screen()->writeText(_panelBuf, _actionDesc.c_str(), kActionRow, kTextCol, 31, true);
+
+		if (!_hotspotDesc.empty() && isLineTouched(kHotspotRow))
+			_vm->screen()->writeText(_panelBuf, _hotspotDesc.c_str(), kHotspotRow, kTextCol, 31, true);
+	}
 
 	// FIXME: check loading in the middle of object animation
 	if (_isLoading)
 		return;
 
-	_vm->screen()->drawPanel(_panelBuf);
+	_vm->screen()->drawPanelRows(_panelBuf, _dirtyTop, _dirtyBottom);
+	_dirtyTop = PANEL_H;
+	_dirtyBottom = 0;
 
 	// Draw got and lost objects
 
@@ -212,7 +241,9 @@ void Panel::showLoading(bool isLoading, bool clearScreen) {
 		_isLoading = isLoading;
 
 		update();
-		_vm->screen()->drawPanel(_panelBuf);
+		_vm->screen()->drawPanelRows(_panelBuf, 0, PANEL_H);
+		_dirtyTop = PANEL_H;
+		_dirtyBottom = 0;
 
 		Actor *mouse = _vm->actorMan()->getMouse();
 		if (_isLoading) {
@@ -230,19 +261,30 @@ void Panel::showLoading(bool isLoading, bool clearScreen) {
 	}
 }
 
-void Panel::setLocationDesc(const char *desc) {
-	_locationDesc = desc;
+/**
+ * Sets the text of the line at row, marking its band for redraw only if
+ * the text changed.
+ */
+void Panel::setDesc(String &desc, const char *newDesc, int row) {
+	if (desc == newDesc)
+		return;
+
+	desc = newDesc;
+	_dirtyTop = MIN<int16>(_dirtyTop, row - 1);
+	_dirtyBottom = MAX<int16>(_dirtyBottom, row + 9);
 	_isDirty = true;
 }
 
+void Panel::setLocationDesc(const char *desc) {
+	setDesc(_locationDesc, desc, kLocationRow);
+}
+
 void Panel::setActionDesc(const char *desc) {
-	_actionDesc = desc;
-	_isDirty = true;
+	setDesc(_actionDesc, desc, kActionRow);
 }
 
 void Panel::setHotspotDesc(const char *desc) {
-	_hotspotDesc = desc;
-	_isDirty = true;
+	setDesc(_hotspotDesc, desc, kHotspotRow);
 }
 
 } // End of namespace Kom
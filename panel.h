@@ -44,7 +44,7 @@ public:
 	void setActionDesc(const char *desc);
 	void setHotspotDesc(const char *desc);
 	bool isEnabled() const { return _isEnabled; }
-	bool isDirty() const { return _isDirty; }
+	bool isDirty() const;
 	void enable(bool state) { _isEnabled = state; }
 	void clear();
 
@@ -54,6 +54,9 @@ public:
 
 private:
 
+	void setDesc(Common::String &desc, const char *newDesc, int row);
+	bool isLineTouched(int row) const;
+
 	KomEngine *_vm;
 
 	byte *_panelData;
@@ -64,6 +67,10 @@ private:
 	bool _isDirty;
 	int _suppressLoading;
 
+	// Panel rows to be redrawn from the background on the next update()
+	int16 _dirtyTop;
+	int16 _dirtyBottom;
+
 	Common::String _locationDesc;
 	Common::String _actionDesc;
 	Common::String _hotspotDesc;
@@ -44,6 +44,7 @@
 #include "kom/kom.h"
 #include "kom/panel.h"
 #include "kom/actor.h"
+#include "kom/blit.h"
 #include "kom/game.h"
 #include "kom/character.h"
 #include "kom/database.h"
@@ -73,6 +74,28 @@ ColorSet::ColorSet(const Path &filename) {
 	f.close();
 }
 
+/** A decoded room background frame, see Screen::updateBackground() */
+struct BackgroundFrame {
+	~BackgroundFrame() { surface.free(); }
+
+	Graphics::Surface surface;
+	uint32 changedTiles[DIRTY_TILES_Y]; // Since the previous frame
+};
+
+/**
+ * An actor frame scaled to width x height, see Screen::getScaledFrame().
+ * opaqueRows is non-zero for rows that have opaque pixels.
+ */
+struct ScaledFrame {
+	~ScaledFrame() { delete[] pixels; }
+
+	const ActorFrame *frame;
+	int16 width;
+	int16 height;
+	byte *pixels;
+	byte *opaqueRows;
+};
+
 ColorSet::~ColorSet() {
 	delete[] data;
 }
@@ -80,17 +103,32 @@ ColorSet::~ColorSet() {
 Screen::Screen(KomEngine *vm, OSystem *system)
 	: _system(system), _vm(vm), _sepiaScreen(0),
 	  _fullRedraw(false), _paletteChanged(false), _currBrightness(0), _newBrightness(256),
-	  _narratorScrollText(0), _narratorWord(0), _narratorTextSurface(0),
-	  _narratorScrollStatus(0), _isFading(false), _pulseFadeRed(false),
+	  _narratorScrollText(0), _narratorStrip(0), _narratorScrollPos(0),
+	  _narratorScrollEnd(0), _narratorScrollSpeed(0), _narratorScrollTimer(0), _isFading(false), _pulseFadeRed(false),
 	  _fadeTargetBrightness(256), _fadeSpeed(0) {
 
-	_lastFrameTime = 0;
+	_shownPaletteValid = false;
+	_talkBackground = 0;
+	_panelOverdrawTop = ROOM_H;
+	_panelOverdrawBottom = SCREEN_H;
+	_bgDrawn = false;
+	_bgCacheEnabled = false;
+	_bgCacheComplete = false;
+	_bgFrameIndex = 0;
+	_bgFrameDelay = 0;
+	_bgFirstFrameTime = 0;
+	_bgNextFrameTime = 0;
+	_bgHasPalette = false;
+	memset(_bgChangedTiles, 0, sizeof(_bgChangedTiles));
+	memset(_bgOverdrawnTiles, 0, sizeof(_bgOverdrawnTiles));
+	resetFrameStats();
+	rebaseFrameSchedule();
 
 	_screenBuf = new uint8[SCREEN_W * SCREEN_H];
 	memset(_screenBuf, 0, SCREEN_W * SCREEN_H);
 
-	_mouseBuf = new uint8[MOUSE_W * MOUSE_H];
-	memset(_mouseBuf, 0, MOUSE_W * MOUSE_H);
+	_cursorFrame = -1;
+	_cursorX = _cursorY = 0;
 
 	_c0ColorSet = new ColorSet("kom/oneoffs/c0_127.cl");
 	_orangeColorSet = new ColorSet("kom/oneoffs/sepia_or.cl");
@@ -99,22 +137,32 @@ Screen::Screen(KomEngine *vm, OSystem *system)
 	_roomMask = 0;
 	_roomBackground = 0;
 
+	memset(_maskRowRuns, 0, sizeof(_maskRowRuns));
+	memset(_maskRowMin, 0, sizeof(_maskRowMin));
+	memset(_maskRowMax, 0, sizeof(_maskRowMax));
+
 	_font = new Font("kom/oneoffs/packfont.fnt");
 
-	_dirtyRects = new List<Rect>();
-	_prevDirtyRects = new List<Rect>();
+	memset(_dirtyTiles, 0, sizeof(_dirtyTiles));
+	memset(_prevDirtyTiles, 0, sizeof(_prevDirtyTiles));
+
+	memset(_colScaleTables, 0, sizeof(_colScaleTables));
+	memset(_lineScaleTables, 0, sizeof(_lineScaleTables));
+	_scaledFramesSize = 0;
 }
 
 Screen::~Screen() {
+	clearBackgroundCache();
+	for (Common::List<ScaledFrame *>::iterator i = _scaledFrames.begin(); i != _scaledFrames.end(); ++i)
+		delete *i;
 	delete[] _screenBuf;
-	delete[] _mouseBuf;
+	for (uint i = 0; i < _cursors.size(); ++i)
+		delete[] _cursors[i];
 	delete _c0ColorSet;
 	delete _orangeColorSet;
 	delete _greenColorSet;
 	delete[] _sepiaScreen;
 	delete _font;
-	delete _dirtyRects;
-	delete _prevDirtyRects;
 }
 
 bool Screen::init() {
@@ -176,15 +224,8 @@ void Screen::processGraphics(int mode, bool samplePlaying) {
 
 		// Figure out fight distance from player
 		int distance = 0;
-		if (playerChar->_lastLocation != fighter->_lastLocation) {
-			int fightLoc = fighter->_lastLocation;
-			int newLoc = playerChar->_lastLocation;
-			for (distance = 1; distance < 5; distance++) {
-				newLoc = _vm->database()->loc2loc(newLoc, fightLoc);
-				if (newLoc == -1)
-					break;
-			}
-		}
+		if (playerChar->_lastLocation != fighter->_lastLocation)
+			distance = MIN(_vm->database()->locDistance(playerChar->_lastLocation, fighter->_lastLocation) + 1, 5);
 
 		_vm->sound()->setSampleVolume(_vm->_weaponSample, _vm->_distanceVolumeTable[distance]);
 
@@ -629,16 +670,97 @@ void Screen::processGraphics(int mode, bool samplePlaying) {
 		gfxUpdate();
 }
 
-void Screen::copyRectListToScreen(const Common::List<Common::Rect> *list) {
+static void markTiles(uint32 *tiles, int left, int top, int right, int bottom) {
+	left = MAX(left, 0);
+	top = MAX(top, 0);
+	right = MIN(right, (int)SCREEN_W);
+	bottom = MIN(bottom, (int)SCREEN_H);
+
+	if (left >= right || top >= bottom)
+		return;
+
+	int firstCol = left / DIRTY_TILE_W;
+	int lastCol = (right - 1) / DIRTY_TILE_W;
+	uint32 cols = ((2u << lastCol) - 1) & ~((1u << firstCol) - 1);
+
+	for (int row = top / DIRTY_TILE_H; row <= (bottom - 1) / DIRTY_TILE_H; ++row)
+		tiles[row] |= cols;
+}
+
+void Screen::markDirty(int left, int top, int right, int bottom) {
+	markTiles(_dirtyTiles, left, top, right, bottom);
+	markTiles(_bgOverdrawnTiles, left, top, right, bottom);
+
+	// Something other than a talk frame was drawn in the room
+	if (top < ROOM_H)
+		_talkBackground = 0;
+
+	if (bottom > ROOM_H) {
+		_panelOverdrawTop = MIN<int>(_panelOverdrawTop, MAX<int>(top, ROOM_H));
+		_panelOverdrawBottom = MAX<int>(_panelOverdrawBottom, MIN<int>(bottom, SCREEN_H));
+	}
+}
+
+void Screen::forceFullRedraw() {
+	_fullRedraw = true;
+	_talkBackground = 0;
+	_bgDrawn = false;
+	_panelOverdrawTop = ROOM_H;
+	_panelOverdrawBottom = SCREEN_H;
+}
+
+/**
+ * Copies the marked tiles to the screen. Runs of tiles in a row become one
+ * rect, which grows downwards as long as the rows below have the same run.
+ */
+void Screen::copyTilesToScreen(const uint32 *tiles) {
+	int8 openEnd[DIRTY_TILES_X];
+	int8 openTop[DIRTY_TILES_X];
+
+	memset(openEnd, -1, sizeof(openEnd));
+
+	for (int row = 0; row <= DIRTY_TILES_Y; ++row) {
+		uint32 bits = row < DIRTY_TILES_Y ? tiles[row] : 0;
+		uint32 continued = 0;
 
-	for (Common::List<Rect>::const_iterator rect = list->begin(); rect != list->end(); ++rect) {
-		debug(9, "copyRectToScreen(%hu, %hu, %hu, %hu)", rect->left, rect->top,
-				rect->width(), rect->height());
-		_system->copyRectToScreen(_screenBuf + SCREEN_W * rect->top + rect->left,
-				SCREEN_W, rect->left, rect->top, rect->width(), rect->height());
+		for (int col = 0; col < DIRTY_TILES_X; ) {
+			if (!(bits & (1u << col))) {
+				col++;
+				continue;
+			}
+
+			int start = col;
+			while (col < DIRTY_TILES_X && (bits & (1u << col)))
+				col++;
+
+			if (openEnd[start] != col) {
+				if (openEnd[start] != -1)
+					copyTileRectToScreen(start, openTop[start], openEnd[start], row);
+				openEnd[start] = col;
+				openTop[start] = row;
+			}
+			continued |= 1u << start;
+		}
+
+		for (int start = 0; start < DIRTY_TILES_X; ++start) {
+			if (openEnd[start] != -1 && !(continued & (1u << start))) {
+				copyTileRectToScreen(start, openTop[start], openEnd[start], row);
+				openEnd[start] = -1;
+			}
+		}
 	}
 }
 
+void Screen::copyTileRectToScreen(int left, int top, int right, int bottom) {
+	int x = left * DIRTY_TILE_W;
+	int y = top * DIRTY_TILE_H;
+	int w = (right - left) * DIRTY_TILE_W;
+	int h = (bottom - top) * DIRTY_TILE_H;
+
+	debug(9, "copyRectToScreen(%d, %d, %d, %d)", x, y, w, h);
+	_system->copyRectToScreen(_screenBuf + SCREEN_W * y + x, SCREEN_W, x, y, w, h);
+}
+
 void Screen::drawDirtyRects() {
 
 	// Copy everything
@@ -646,20 +768,17 @@ void Screen::drawDirtyRects() {
 		_system->copyRectToScreen(_screenBuf, SCREEN_W, 0, 0, SCREEN_W, SCREEN_H);
 
 	} else {
-		// No need to save a prev, since the background reports
-		// all changes
+		uint32 tiles[DIRTY_TILES_Y];
 
-		if (_roomBackgroundFlic.isVideoLoaded()) {
-			copyRectListToScreen(_roomBackgroundFlic.getDirtyRects());
-			_roomBackgroundFlic.clearDirtyRects();
-		}
+		for (int row = 0; row < DIRTY_TILES_Y; ++row)
+			tiles[row] = _dirtyTiles[row] | _prevDirtyTiles[row];
 
-		// Copy dirty rects to screen
-		copyRectListToScreen(_prevDirtyRects);
-		copyRectListToScreen(_dirtyRects);
-		delete _prevDirtyRects;
-		_prevDirtyRects = _dirtyRects;
-		_dirtyRects = new List<Rect>();
+		// Background changes are marked by drawBackground()
+
+		// Copy dirty tiles to screen
+		copyTilesToScreen(tiles);
+		memcpy(_prevDirtyTiles, _dirtyTiles, sizeof(_dirtyTiles));
+		memset(_dirtyTiles, 0, sizeof(_dirtyTiles));
 	}
 
 	_fullRedraw = false;
@@ -693,9 +812,43 @@ void Screen::gfxUpdate() {
 	// FIXME: this shouldn't be called. doesn't allow long key presses
 	_vm->input()->resetInput();
 
-	while (_system->getMillis() < _lastFrameTime + 41 /* 24 fps */) {
-		_vm->input()->checkKeys();
-		_system->delayMillis(10);
+	// Wait for the frame's deadline. Deadlines are counted from a base
+	// time, so waits don't accumulate rounding or oversleeping
+	uint32 now = _system->getMillis();
+	uint32 deadline = _frameBase + (_frameNum + 1) * 1000 / FRAME_RATE;
+	uint32 work = now - _lastFrameTime;
+
+	if (_skipFrameStats) {
+		// The time since the last frame was spent loading or playing a
+		// video, so it says nothing about the frame
+		_skipFrameStats = false;
+		_frameBase = now;
+		_frameNum = 0;
+
+	} else {
+		_frameStats.frames++;
+		_frameStats.totalWork += work;
+		_frameStats.maxWork = MAX(_frameStats.maxWork, work);
+
+		if (now >= deadline) {
+			// Start a new schedule rather than rushing frames to catch up
+			_frameStats.lateFrames++;
+			_frameStats.maxLateness = MAX(_frameStats.maxLateness, now - deadline);
+			_frameBase = now;
+			_frameNum = 0;
+
+		} else {
+			if (++_frameNum == FRAME_RATE) {
+				_frameBase += 1000;
+				_frameNum = 0;
+			}
+
+			while (now < deadline) {
+				_vm->input()->checkKeys();
+				_system->delayMillis(MIN<uint32>(deadline - now, 10));
+				now = _system->getMillis();
+			}
+		}
 	}
 
 	if (CursorMan.isVisible())
@@ -705,12 +858,26 @@ void Screen::gfxUpdate() {
 	_lastFrameTime = _system->getMillis();
 }
 
+void Screen::resetFrameStats() {
+	memset(&_frameStats, 0, sizeof(_frameStats));
+}
+
+/**
+ * Starts a new frame schedule from now, and leaves the next frame out of
+ * the stats. Called after operations that block the game loop.
+ */
+void Screen::rebaseFrameSchedule() {
+	_lastFrameTime = _frameBase = _system->getMillis();
+	_frameNum = 0;
+	_skipFrameStats = true;
+}
+
 void Screen::clearScreen(bool now) {
-	_dirtyRects->clear();
-	_prevDirtyRects->clear();
+	memset(_dirtyTiles, 0, sizeof(_dirtyTiles));
+	memset(_prevDirtyTiles, 0, sizeof(_prevDirtyTiles));
 
 	memset(_screenBuf, 0, SCREEN_W * SCREEN_H);
-	_fullRedraw = true;
+	forceFullRedraw();
 
 	if (now) {
 		_system->copyRectToScreen(_screenBuf, SCREEN_W, 0, 0, SCREEN_W, SCREEN_H);
@@ -720,11 +887,15 @@ void Screen::clearScreen(bool now) {
 
 void Screen::clearRoom() {
 	memset(_screenBuf, 0, SCREEN_W * (SCREEN_H - PANEL_H));
-	_dirtyRects->push_back(Rect(0, 0, SCREEN_W, SCREEN_H - PANEL_H));
+	markDirty(0, 0, SCREEN_W, SCREEN_H - PANEL_H);
 }
 
 void Screen::copyBackground(const Graphics::Surface *surface) {
 	memset(_screenBuf, 0, SCREEN_W * SCREEN_H);
+	_talkBackground = 0;
+	_bgDrawn = false;
+	_panelOverdrawTop = ROOM_H;
+	_panelOverdrawBottom = SCREEN_H;
 
 	if (!surface)
 		return;
@@ -737,14 +908,125 @@ void Screen::copyBackground(const Graphics::Surface *surface) {
 
 static byte lineBuffer[SCREEN_W];
 
-void Screen::drawActorFrameScaled(const int8 *data, uint16 width, uint16 height, int16 xStart, int16 yStart,
+/**
+ * Returns the source index of each pixel of a line scaled from srcSize to
+ * scaledSize, with the first clip pixels cut off. Tables are cached
+ * separately for columns and lines, so a column table stays valid while
+ * the line table of the same draw is looked up.
+ */
+const ScaleTable *Screen::getScaleTable(ScaleTable *cache, uint16 srcSize, uint16 scaledSize, uint16 clip) {
+	uint32 hash = (srcSize * 2654435761U) ^ (scaledSize * 2246822519U) ^ (clip * 3266489917U);
+	hash ^= hash >> 16;
+	ScaleTable *table = &cache[hash % kScaleTableCacheSize];
+
+	if (table->srcSize == srcSize && table->scaledSize == scaledSize && table->clip == clip)
+		return table;
+
+	table->srcSize = srcSize;
+	table->scaledSize = scaledSize;
+	table->clip = clip;
+
+	div_t ratio = div(srcSize, scaledSize);
+	div_t d = div(clip * srcSize, scaledSize);
+
+	uint8 sourcePixel = d.quot;
+	int16 thing = scaledSize - d.rem;
+
+	// A draw never reads past the clipped end of the scaled line
+	int count = MIN<int>(scaledSize - clip, ARRAYSIZE(table->index));
+
+	for (int i = 0; i < count; ++i) {
+		table->index[i] = sourcePixel;
+		table->next[i] = sourcePixel + ratio.quot + ((thing <= ratio.rem) ? 1 : 0);
+
+		sourcePixel += ratio.quot;
+		thing -= ratio.rem;
+
+		if (thing < 0) {
+			sourcePixel++;
+			thing += scaledSize;
+		}
+	}
+
+	return table;
+}
+
+/**
+ * Returns frame scaled to width x height. Scaled frames are kept until
+ * they're purged along with their actor, or until the least recently
+ * used ones are dropped to stay in the budget.
+ */
+const ScaledFrame *Screen::getScaledFrame(const ActorFrame *frame, int16 width, int16 height) {
+	ScaledFrameKey key(frame, width, height);
+
+	if (_scaledFrameIndex.contains(key)) {
+		Common::List<ScaledFrame *>::iterator i = _scaledFrameIndex[key];
+		ScaledFrame *scaled = *i;
+
+		if (i != _scaledFrames.begin()) {
+			_scaledFrames.erase(i);
+			_scaledFrames.push_front(scaled);
+			_scaledFrameIndex[key] = _scaledFrames.begin();
+		}
+		return scaled;
+	}
+
+	ScaledFrame *scaled = new ScaledFrame();
+	scaled->frame = frame;
+	scaled->width = width;
+	scaled->height = height;
+	scaled->pixels = new byte[width * height + height];
+	scaled->opaqueRows = scaled->pixels + width * height;
+
+	const uint8 *colMap = getScaleTable(_colScaleTables, frame->width, width, 0)->index;
+	const uint8 *lineMap = getScaleTable(_lineScaleTables, frame->height, height, 0)->index;
+
+	for (int i = 0; i < height; ++i) {
+		const byte *row = frame->getRow(lineMap[i]);
+		byte *target = scaled->pixels + i * width;
+
+		scaled->opaqueRows[i] = frame->rowSpans[lineMap[i]] != frame->rowSpans[lineMap[i] + 1];
+
+		for (int j = 0; j < width; ++j)
+			target[j] = row[colMap[j]];
+	}
+
+	_scaledFrames.push_front(scaled);
+	_scaledFrameIndex[key] = _scaledFrames.begin();
+	_scaledFramesSize += width * height + height;
+
+	while (_scaledFramesSize > kScaledFrameCacheBudget && _scaledFrames.back() != scaled) {
+		ScaledFrame *old = _scaledFrames.back();
+		_scaledFrames.pop_back();
+		_scaledFrameIndex.erase(ScaledFrameKey(old->frame, old->width, old->height));
+		_scaledFramesSize -= old->width * old->height + old->height;
+		delete old;
+	}
+
+	return scaled;
+}
+
+/** Drops the scaled copies of a frame that is about to be deleted */
+void Screen::purgeScaledFrames(const ActorFrame *frame) {
+	for (Common::List<ScaledFrame *>::iterator i = _scaledFrames.begin(); i != _scaledFrames.end(); ) {
+		ScaledFrame *scaled = *i;
+
+		if (scaled->frame == frame) {
+			_scaledFrameIndex.erase(ScaledFrameKey(scaled->frame, scaled->width, scaled->height));
+			_scaledFramesSize -= scaled->width * scaled->height + scaled->height;
+			delete scaled;
+			i = _scaledFrames.erase(i);
+		} else {
+			++i;
+		}
+	}
+}
+
+void Screen::drawActorFrameScaled(const ActorFrame *frame, int16 xStart, int16 yStart,
                             int16 xEnd, int16 yEnd, int maskDepth, bool invisible) {
 
 	uint16 startLine = 0;
 	uint16 startCol = 0;
-	int32 colSkip = 0;
-	int32 rowSkip = 0;
-	div_t d;
 
 	if (xStart > xEnd)
 		SWAP(xStart, xEnd);
@@ -757,23 +1039,14 @@ void Screen::drawActorFrameScaled(const int8 *data, uint16 width, uint16 height,
 	int16 visibleHeight = yEnd - yStart;
 	int16 scaledHeight = visibleHeight;
 
-	//debug("drawActorFrame(%hu, %hu, %hd, %hd, %hu, %hu)", width, height, xStart, yStart, xEnd, yEnd);
-
 	if (visibleWidth == 0 || visibleHeight == 0) return;
 
-	div_t widthRatio = div(width, scaledWidth);
-	div_t heightRatio = div(height, scaledHeight);
-
 	if (xStart < 0) {
 		// frame is entirely off-screen
 		if ((visibleWidth += xStart) <= 0)
 			return;
 
-		d = div(-xStart * width, scaledWidth);
-		startCol = d.quot;
-		colSkip = d.rem;
-		//debug("startCol: %hu, colSkip: %d", startCol, colSkip);
-
+		startCol = -xStart;
 		xStart = 0;
 	}
 
@@ -790,11 +1063,7 @@ void Screen::drawActorFrameScaled(const int8 *data, uint16 width, uint16 height,
 		if ((visibleHeight += yStart) <= 0)
 			return;
 
-		d = div(-yStart * height, scaledHeight);
-		startLine = d.quot;
-		rowSkip = d.rem;
-		//debug("startLine: %hu, rowSkip: %d", startLine, rowSkip);
-
+		startLine = -yStart;
 		yStart = 0;
 	}
 
@@ -806,62 +1075,99 @@ void Screen::drawActorFrameScaled(const int8 *data, uint16 width, uint16 height,
 		if ((visibleHeight -= visibleHeight + yStart - SCREEN_H) <= 0)
 			return;
 
-	uint8 sourceLine = startLine;
-	uint8 targetLine = yStart;
-	int16 rowThing = scaledHeight - rowSkip;
+	// Frames drawn whole are scaled once and cached. Clipped tables don't
+	// always match a window of the whole one, so clipped frames are
+	// scaled as they're drawn.
+	if (startCol == 0 && startLine == 0 && visibleWidth == scaledWidth && visibleHeight == scaledHeight) {
+		const ScaledFrame *scaled = getScaledFrame(frame, scaledWidth, scaledHeight);
+
+		for (int i = 0; i < visibleHeight; ++i) {
+			uint8 targetLine = yStart + i;
+
+			if (!scaled->opaqueRows[i] ||
+			    (targetLine < ROOM_H && maskDepth > _maskRowMax[targetLine]))
+				continue;
+
+			const byte *src = scaled->pixels + i * scaledWidth;
+			byte *target = _screenBuf + targetLine * SCREEN_W + xStart;
+			const byte *values = invisible ? target + 8 : src;
+
+			if (targetLine >= ROOM_H || maskDepth <= _maskRowMin[targetLine])
+				blendRow(target, src, values, visibleWidth);
+			else
+				blendLineOverMask(target, src, values, targetLine, xStart, visibleWidth, maskDepth);
+		}
+
+		markDirty(xStart, yStart, xStart + visibleWidth, yStart + visibleHeight);
+		return;
+	}
+
+	const uint8 *colMap = getScaleTable(_colScaleTables, frame->width, scaledWidth, startCol)->index;
+	const uint8 *lineMap = getScaleTable(_lineScaleTables, frame->height, scaledHeight, startLine)->index;
 
 	for (int i = 0; i < visibleHeight; i += 1) {
-		uint16 lineOffset = READ_LE_UINT16(data + sourceLine * 2);
+		uint8 sourceLine = lineMap[i];
+		uint8 targetLine = yStart + i;
 
-		uint16 targetPixel = targetLine * SCREEN_W + xStart;
-		drawActorFrameLine(lineBuffer, data + lineOffset, width);
+		// Skip fully transparent lines, and lines hidden by the mask
+		if (frame->rowSpans[sourceLine] == frame->rowSpans[sourceLine + 1] ||
+		    (targetLine < ROOM_H && maskDepth > _maskRowMax[targetLine]))
+			continue;
+
+		const byte *row = frame->getRow(sourceLine);
+		byte *target = _screenBuf + targetLine * SCREEN_W + xStart;
+		const byte *values = invisible ? target + 8 : lineBuffer;
+
+		for (int j = 0; j < visibleWidth; ++j)
+			lineBuffer[j] = row[colMap[j]];
 
 		// Copy line to screen
-		uint8 sourcePixel = startCol;
-		int16 colThing = scaledWidth - colSkip;
+		if (targetLine >= ROOM_H || maskDepth <= _maskRowMin[targetLine])
+			blendRow(target, lineBuffer, values, visibleWidth);
+		else
+			blendLineOverMask(target, lineBuffer, values, targetLine, xStart, visibleWidth, maskDepth);
+	}
 
-		for (int j = 0; j < visibleWidth; ++j) {
-			if (lineBuffer[sourcePixel] != 0
-			    && (targetLine >= ROOM_H || ((const byte *)_roomMask->getPixels())[targetPixel] >= maskDepth)) {
-				if (invisible)
-					_screenBuf[targetPixel] = _screenBuf[targetPixel + 8];
-				else
-					_screenBuf[targetPixel] = lineBuffer[sourcePixel];
-			}
+	markDirty(xStart, yStart, xStart + visibleWidth, yStart + visibleHeight);
+}
 
-			sourcePixel += widthRatio.quot;
-			colThing -= widthRatio.rem;
+/**
+ * Blends the parts of a room line that are in front of the mask, using the
+ * mask runs of the line instead of testing each pixel.
+ */
+void Screen::blendLineOverMask(byte *target, const byte *src, const byte *values,
+		int line, int xStart, int count, int maskDepth) {
+	int xEnd = xStart + count;
+	uint32 lastRun = _maskRowRuns[line + 1];
 
-			if (colThing < 0) {
-				sourcePixel++;
-				colThing += scaledWidth;
-			}
+	for (uint32 r = _maskRowRuns[line]; r < lastRun; ++r) {
+		if (_maskRuns[r].depth < maskDepth)
+			continue;
 
-			targetPixel++;
-		}
+		// Merge with the following visible runs
+		int spanStart = _maskRuns[r].x;
+		while (r + 1 < lastRun && _maskRuns[r + 1].depth >= maskDepth)
+			r++;
+		int spanEnd = (r + 1 < lastRun) ? _maskRuns[r + 1].x : (int)SCREEN_W;
 
-		sourceLine += heightRatio.quot;
-		rowThing -= heightRatio.rem;
+		if (spanEnd <= xStart)
+			continue;
+		if (spanStart >= xEnd)
+			break;
 
-		if (rowThing < 0) {
-			sourceLine++;
-			rowThing += scaledHeight;
-		}
+		spanStart = MAX(spanStart, xStart);
+		spanEnd = MIN(spanEnd, xEnd);
 
-		targetLine++;
+		int offset = spanStart - xStart;
+		blendRow(target + offset, src + offset, values + offset, spanEnd - spanStart);
 	}
-
-	_dirtyRects->push_back(Rect(xStart, yStart, xStart + visibleWidth, yStart + visibleHeight));
 }
 
-void Screen::drawActorFrameScaledAura(const int8 *data, uint16 width, uint16 height, int16 xStart, int16 yStart,
+void Screen::drawActorFrameScaledAura(const ActorFrame *frame, int16 xStart, int16 yStart,
                             int16 xEnd, int16 yEnd, int maskDepth) {
 
 	uint16 startLine = 0;
 	uint16 startCol = 0;
-	int32 colSkip = 0;
-	int32 rowSkip = 0;
-	div_t d;
 
 	memset(lineBuffer, 0, sizeof(lineBuffer));
 
@@ -878,18 +1184,14 @@ void Screen::drawActorFrameScaledAura(const int8 *data, uint16 width, uint16 hei
 
 	if (visibleWidth == 0 || visibleHeight == 0) return;
 
-	div_t widthRatio = div(width, scaledWidth);
-	div_t heightRatio = div(height, scaledHeight);
+	int widthQuot = frame->width / scaledWidth;
 
 	if (xStart < 0) {
 		// frame is entirely off-screen
 		if ((visibleWidth += xStart) <= 0)
 			return;
 
-		d = div(-xStart * width, scaledWidth);
-		startCol = d.quot;
-		colSkip = d.rem;
-
+		startCol = -xStart;
 		xStart = 0;
 	}
 
@@ -906,11 +1208,7 @@ void Screen::drawActorFrameScaledAura(const int8 *data, uint16 width, uint16 hei
 		if ((visibleHeight += yStart) <= 0)
 			return;
 
-		d = div(-yStart * height, scaledHeight);
-		startLine = d.quot;
-		rowSkip = d.rem;
-		//debug("startLine: %hu, rowSkip: %d", startLine, rowSkip);
-
+		startLine = -yStart;
 		yStart = 0;
 	}
 
@@ -922,75 +1220,53 @@ void Screen::drawActorFrameScaledAura(const int8 *data, uint16 width, uint16 hei
 		if ((visibleHeight -= visibleHeight + yStart - SCREEN_H) <= 0)
 			return;
 
-	uint8 sourceLine = startLine;
-	uint8 targetLine = yStart;
-	int16 rowThing = scaledHeight - rowSkip;
+	const ScaleTable *colTable = getScaleTable(_colScaleTables, frame->width, scaledWidth, startCol);
+	const uint8 *lineMap = getScaleTable(_lineScaleTables, frame->height, scaledHeight, startLine)->index;
 
 	for (int i = 0; i < visibleHeight; i += 1) {
-		uint16 lineOffset = READ_LE_UINT16(data + sourceLine * 2);
-
-		bool startOfLine = (xStart == 0);
+		uint8 sourceLine = lineMap[i];
+		uint8 targetLine = yStart + i;
 		uint16 targetPixel = targetLine * SCREEN_W + xStart;
-		drawActorFrameLine(lineBuffer, data + lineOffset, width);
 
-		// Copy line to screen
-		int skipped = 0;
-		uint8 sourcePixel = startCol;
-		int16 colThing = scaledWidth - colSkip;
+		// The border checks look past the edges of the line, so keep
+		// it in the zero-padded line buffer
+		memcpy(lineBuffer, frame->getRow(sourceLine), frame->width);
 
+		// Copy line to screen
 		for (int j = 0; j < visibleWidth; ++j) {
+			uint8 sourcePixel = colTable->index[j];
+
 			if (lineBuffer[sourcePixel] != 0
 			    && (targetLine >= ROOM_H || ((const byte *)_roomMask->getPixels())[targetPixel] >= maskDepth)) {
 
 				_screenBuf[targetPixel] = lineBuffer[sourcePixel];
 
 				// Draw border to the left and right
-				if (!startOfLine) {
-					if (lineBuffer[sourcePixel - widthRatio.quot - skipped] == 0)
+				if (j > 0 || xStart != 0) {
+					uint8 prevPixel = j > 0 ? colTable->index[j - 1] : (uint8)(sourcePixel - widthQuot);
+					if (lineBuffer[prevPixel] == 0)
 						_screenBuf[targetPixel-1] = 14;
 				}
 				if (xStart + visibleWidth < SCREEN_W) {
-					if (lineBuffer[sourcePixel + widthRatio.quot + ((colThing <= widthRatio.rem) ? 1 : 0)] == 0)
+					if (lineBuffer[colTable->next[j]] == 0)
 						_screenBuf[targetPixel+1] = 14;
 				}
 			}
 
-			skipped = 0;
-			sourcePixel += widthRatio.quot;
-			colThing -= widthRatio.rem;
-
-			if (colThing < 0) {
-				sourcePixel++;
-				colThing += scaledWidth;
-				skipped = 1;
-			}
-
 			targetPixel++;
-			startOfLine = false;
 		}
-
-		sourceLine += heightRatio.quot;
-		rowThing -= heightRatio.rem;
-
-		if (rowThing < 0) {
-			sourceLine++;
-			rowThing += scaledHeight;
-		}
-
-		targetLine++;
 	}
 
-	_dirtyRects->push_back(Rect(MAX(0, xStart - 1), yStart, MIN((int)SCREEN_W, xStart + visibleWidth + 1), yStart + visibleHeight));
+	markDirty(MAX(0, xStart - 1), yStart, MIN((int)SCREEN_W, xStart + visibleWidth + 1), yStart + visibleHeight);
 }
 
-void Screen::drawActorFrame(const int8 *data, uint16 width, uint16 height, int16 xStart, int16 yStart,
-		bool greyedOut) {
+void Screen::drawActorFrame(const ActorFrame *frame, int16 xStart, int16 yStart, bool greyedOut) {
 
 	uint16 startLine = 0;
 	uint16 startCol = 0;
 
-	int16 visibleWidth = width;
-	int16 visibleHeight = height;
+	int16 visibleWidth = frame->width;
+	int16 visibleHeight = frame->height;
 
 	if (visibleWidth == 0 || visibleHeight == 0) return;
 
@@ -1032,69 +1308,84 @@ void Screen::drawActorFrame(const int8 *data, uint16 width, uint16 height, int16
 	uint8 targetLine = yStart;
 
 	uint8 inc = greyedOut ? 2 : 1;
+	int endCol = startCol + visibleWidth;
 
 	for (int i = 0; i < visibleHeight; i += inc) {
-		uint16 lineOffset = READ_LE_UINT16(data + sourceLine * 2);
-
-		uint16 targetPixel = targetLine * SCREEN_W + xStart;
-		drawActorFrameLine(lineBuffer, data + lineOffset, width);
+		const byte *row = frame->getRow(sourceLine);
+		byte *target = _screenBuf + targetLine * SCREEN_W + xStart - startCol;
 
-		// Copy line to screen
-		uint8 sourcePixel = startCol;
+		if (greyedOut) {
+			for (int j = startCol; j < endCol; j += inc)
+				if (row[j] != 0)
+					target[j] = row[j];
+		} else {
+			// Copy the opaque spans of the line to screen
+			for (uint32 s = frame->rowSpans[sourceLine]; s < frame->rowSpans[sourceLine + 1]; s += 2) {
+				int spanStart = MAX<int>(frame->spans[s], startCol);
+				int spanEnd = MIN<int>(frame->spans[s] + frame->spans[s + 1], endCol);
 
-		for (int j = 0; j < visibleWidth; j += inc) {
-			if (lineBuffer[sourcePixel] != 0)
-				_screenBuf[targetPixel] = lineBuffer[sourcePixel];
-			sourcePixel += inc;
-			targetPixel += inc;
+				if (spanStart < spanEnd)
+					memcpy(target + spanStart, row + spanStart, spanEnd - spanStart);
+			}
 		}
 
 		sourceLine += inc;
 		targetLine += inc;
 	}
 
-	_dirtyRects->push_back(Rect(xStart, yStart, xStart + visibleWidth, yStart + visibleHeight));
+	markDirty(xStart, yStart, xStart + visibleWidth, yStart + visibleHeight);
 }
 
-void Screen::drawMouseFrame(const int8 *data, uint16 width, uint16 height, int16 xOffset, int16 yOffset) {
+/**
+ * Returns the cursor bitmap of a mouse actor frame, decoding it on first
+ * use.
+ */
+const byte *Screen::cacheCursor(int16 frameId, const ActorFrame *frame) {
+	if ((uint16)frameId >= _cursors.size()) {
+		uint oldSize = _cursors.size();
+		_cursors.resize(frameId + 1);
+		for (uint i = oldSize; i < _cursors.size(); ++i)
+			_cursors[i] = NULL;
+	}
+
+	if (_cursors[frameId])
+		return _cursors[frameId];
 
-	memset(_mouseBuf, 0, MOUSE_W * MOUSE_H);
+	byte *cursor = new byte[MOUSE_W * MOUSE_H];
+	memset(cursor, 0, MOUSE_W * MOUSE_H);
 
-	for (int line = 0; line <= height - 1; ++line) {
-		uint16 lineOffset = READ_LE_UINT16(data + line * 2);
+	for (int line = 0; line < frame->height; ++line) {
+		const byte *row = frame->getRow(line);
 
-		drawActorFrameLine(lineBuffer, data + lineOffset, width);
-		for (int i = 0; i < width; ++i)
-			if (lineBuffer[i] != 0)
-				_mouseBuf[line * MOUSE_W + i] = lineBuffer[i];
+		for (uint32 s = frame->rowSpans[line]; s < frame->rowSpans[line + 1]; s += 2)
+			memcpy(cursor + line * MOUSE_W + frame->spans[s], row + frame->spans[s], frame->spans[s + 1]);
 	}
 
-	setMouseCursor(_mouseBuf, MOUSE_W, MOUSE_H, -xOffset, -yOffset);
+	_cursors[frameId] = cursor;
+	return cursor;
 }
 
-void Screen::drawActorFrameLine(byte *outBuffer, const int8 *rowData, uint16 length) {
-	uint8 dataIndex = 0;
-	uint8 outIndex = 0;
+/**
+ * Sets the cursor to a mouse actor frame. The backend is only told when
+ * the frame or its hotspot changes.
+ */
+void Screen::drawMouseFrame(int16 frameId, const ActorFrame *frame, int16 xOffset, int16 yOffset) {
+	if (frameId == _cursorFrame && xOffset == _cursorX && yOffset == _cursorY)
+		return;
+
+	setMouseCursor(cacheCursor(frameId, frame), MOUSE_W, MOUSE_H, -xOffset, -yOffset);
 
-	while (outIndex < length) {
-		// FIXME: valgrind reports invalid read of size 1
-		int8 imageData = rowData[dataIndex++];
-		if (imageData > 0)
-			while (imageData-- > 0)
-				outBuffer[outIndex++] = 0;
-		else if ((imageData &= 0x7F) > 0)
-			while (imageData-- > 0)
-				// FIXME: valgrind reports invalid read of size 1
-				outBuffer[outIndex++] = rowData[dataIndex++];
-	}
+	_cursorFrame = frameId;
+	_cursorX = xOffset;
+	_cursorY = yOffset;
 }
 
 void Screen::useColorSet(ColorSet *cs, uint start, bool applyImmediately) {
 	static const byte black[] = { 0, 0, 0 };
 
 	if (applyImmediately) {
-		_system->getPaletteManager()->setPalette(cs->data, start, cs->size);
-		_system->getPaletteManager()->setPalette(black, 0, 1);
+		setSystemPalette(cs->data, start, cs->size);
+		setSystemPalette(black, 0, 1);
 		return;
 	}
 
@@ -1149,47 +1440,85 @@ void Screen::doFadeTo() {
 	_newBrightness = _currBrightness;
 }
 
+void Screen::setSystemPalette(const byte *colors, uint start, uint num) {
+	_system->getPaletteManager()->setPalette(colors, start, num);
+
+	memcpy(_shownPalette + start * 3, colors, num * 3);
+	if (start == 0 && num == 256)
+		_shownPaletteValid = true;
+}
+
+/** Sends the entries of palette that differ from the shown palette */
+void Screen::pushPalette(const byte *palette) {
+	uint first = 0;
+	uint last = 256;
+
+	if (_shownPaletteValid) {
+		while (first < last && memcmp(palette + first * 3, _shownPalette + first * 3, 3) == 0)
+			first++;
+
+		if (first == last)
+			return;
+
+		while (memcmp(palette + (last - 1) * 3, _shownPalette + (last - 1) * 3, 3) == 0)
+			last--;
+	}
+
+	setSystemPalette(palette + first * 3, first, last - first);
+}
+
 void Screen::updatePaletteWithBrightness() {
 	byte newPalette[256 * 3];
+	byte ramp[256];
 
 	_paletteChanged = false;
+	_newBrightness = 9999;
 
-	if (_currBrightness <= 256) {
-		if (_currBrightness == 256) {
-			_system->getPaletteManager()->setPalette(_palette, 0, 256);
-		} else {
-			for (uint i = 0; i < 256 * 3; i++) {
-				newPalette[i] = _palette[i] * _currBrightness / 256;
-			}
-			_system->getPaletteManager()->setPalette(newPalette, 0, 256);
-		}
+	if (_currBrightness == 256) {
+		pushPalette(_palette);
+		return;
+	}
+
+	// Apply the brightness through a ramp of all channel values
+	if (_currBrightness < 256) {
+		for (uint i = 0; i < 256; i++)
+			ramp[i] = i * _currBrightness / 256;
+
+		for (uint i = 0; i < 256 * 3; i++)
+			newPalette[i] = ramp[_palette[i]];
 
-		_newBrightness = 9999;
 	} else {
-		uint16 mod = PALETTE_6BIT_TO_8BIT(_currBrightness - 256);
+		int mod = PALETTE_6BIT_TO_8BIT(_currBrightness - 256);
+
+		for (uint i = 0; i < 256; i++)
+			ramp[i] = MIN((int)i + mod, 255);
+
 		if (_pulseFadeRed) {
-			for (uint i = 0; i < 256 * 3; i++) {
-				newPalette[i] = MIN((uint16)_palette[i] + mod, 255);
-				i++;
-				newPalette[i] = MAX((uint16)_palette[i] - mod, 0);
-				i++;
-				newPalette[i] = MAX((uint16)_palette[i] - mod, 0);
+			byte down[256];
+
+			for (uint i = 0; i < 256; i++)
+				down[i] = MAX((int)i - mod, 0);
+
+			for (uint i = 0; i < 256 * 3; i += 3) {
+				newPalette[i] = ramp[_palette[i]];
+				newPalette[i + 1] = down[_palette[i + 1]];
+				newPalette[i + 2] = down[_palette[i + 2]];
 			}
 		} else {
-			for (uint i = 0; i < 256 * 3; i++) {
-				newPalette[i] = MIN((uint16)_palette[i] + mod, 255);
-			}
+			for (uint i = 0; i < 256 * 3; i++)
+				newPalette[i] = ramp[_palette[i]];
 		}
-		_newBrightness = 9999;
-		_system->getPaletteManager()->setPalette(newPalette, 0, 256);
 	}
+
+	pushPalette(newPalette);
 }
 
 void Screen::createSepia(bool shop) {
 	_sepiaScreen = new byte[SCREEN_W * ROOM_H];
 	ColorSet *cs = shop ? _greenColorSet : _orangeColorSet;
+	byte sepiaIndex[256];
 
-	_fullRedraw = true;
+	forceFullRedraw();
 	drawDirtyRects();
 
 	Graphics::Surface *screen = _system->lockScreen();
@@ -1197,16 +1526,19 @@ void Screen::createSepia(bool shop) {
 
 	_system->getPaletteManager()->grabPalette(_sepiaBackupPalette, 0, 256);
 
-	for (uint y = 0; y < ROOM_H; ++y) {
-		for (uint x = 0; x < SCREEN_W; ++x) {
-			byte *color = &_sepiaBackupPalette[((uint8*)screen->getPixels())[y * SCREEN_W + x] * 3];
-			_sepiaScreen[y * SCREEN_W + x] =
-					(PALETTE_8BIT_TO_6BIT(color[0]) +
-					 PALETTE_8BIT_TO_6BIT(color[1]) +
-					 PALETTE_8BIT_TO_6BIT(color[2])) / 12 + 232;
-		}
+	// Map each color to its sepia shade once, rather than per pixel
+	for (uint i = 0; i < 256; ++i) {
+		const byte *color = &_sepiaBackupPalette[i * 3];
+		sepiaIndex[i] =
+				(PALETTE_8BIT_TO_6BIT(color[0]) +
+				 PALETTE_8BIT_TO_6BIT(color[1]) +
+				 PALETTE_8BIT_TO_6BIT(color[2])) / 12 + 232;
 	}
 
+	const byte *pixels = (const byte *)screen->getPixels();
+	for (uint i = 0; i < SCREEN_W * ROOM_H; ++i)
+		_sepiaScreen[i] = sepiaIndex[pixels[i]];
+
 	_system->unlockScreen();
 
 	useColorSet(cs, 224);
@@ -1218,9 +1550,9 @@ void Screen::freeSepia() {
 
 	delete[] _sepiaScreen;
 	_sepiaScreen = 0;
-	_system->getPaletteManager()->setPalette(_sepiaBackupPalette, 0, 256);
+	pushPalette(_sepiaBackupPalette);
 
-	_fullRedraw = true;
+	forceFullRedraw();
 }
 
 void Screen::copySepia() {
@@ -1228,7 +1560,7 @@ void Screen::copySepia() {
 		return;
 
 	memcpy(_screenBuf, _sepiaScreen, SCREEN_W * ROOM_H);
-	_dirtyRects->push_back(Rect(0, 0, SCREEN_W, SCREEN_H));
+	markDirty(0, 0, SCREEN_W, SCREEN_H);
 }
 
 void Screen::setMouseCursor(const byte *buf, uint w, uint h, int hotspotX, int hotspotY) {
@@ -1440,12 +1772,30 @@ void Screen::updateActionStrings() {
 
 void Screen::drawPanel(const byte *panelData) {
 	memcpy(_screenBuf + SCREEN_W * ROOM_H, panelData, SCREEN_W * PANEL_H);
-	_dirtyRects->push_back(Rect(0, ROOM_H, SCREEN_W, SCREEN_H));
+	markDirty(0, ROOM_H, SCREEN_W, SCREEN_H);
+}
+
+/**
+ * Copies rows top to bottom of the panel to the screen, along with the
+ * panel rows anything else has drawn over since the last call.
+ */
+void Screen::drawPanelRows(const byte *panelData, int top, int bottom) {
+	top = MIN<int>(top + ROOM_H, _panelOverdrawTop);
+	bottom = MAX<int>(bottom + ROOM_H, _panelOverdrawBottom);
+
+	_panelOverdrawTop = SCREEN_H;
+	_panelOverdrawBottom = ROOM_H;
+
+	if (top >= bottom)
+		return;
+
+	memcpy(_screenBuf + SCREEN_W * top, panelData + SCREEN_W * (top - ROOM_H), SCREEN_W * (bottom - top));
+	markTiles(_dirtyTiles, 0, top, SCREEN_W, bottom);
 }
 
 void Screen::clearPanel() {
 	memset(_screenBuf + SCREEN_W * (SCREEN_H - PANEL_H), 0, SCREEN_W * PANEL_H);
-	_dirtyRects->push_back(Rect(0, SCREEN_H - PANEL_H, SCREEN_W, SCREEN_H));
+	markDirty(0, SCREEN_H - PANEL_H, SCREEN_W, SCREEN_H);
 }
 
 void Screen::updatePanelOnScreen(bool clearScreenFlag) {
@@ -1469,50 +1819,283 @@ void Screen::loadBackground(const Path &filename) {
 	_roomBackgroundFlic.loadFile(filename);
 	_roomBackgroundFlic.start();
 
+	// Cache the frames of still backgrounds and short loops, so they're
+	// only decoded once
+	_roomBackground = 0;
+	clearBackgroundCache();
+	uint32 frameSize = _roomBackgroundFlic.getWidth() * _roomBackgroundFlic.getHeight();
+	uint32 frameCount = _roomBackgroundFlic.getFrameCount();
+	_bgCacheEnabled = frameCount * frameSize <= kBackgroundCacheBudget;
+
 	// Redraw everything
-	_dirtyRects->clear();
-	_prevDirtyRects->clear();
-	// No need to report the rect, since the flic player will report it
+	memset(_dirtyTiles, 0, sizeof(_dirtyTiles));
+	memset(_prevDirtyTiles, 0, sizeof(_prevDirtyTiles));
+	memset(_bgChangedTiles, 0, sizeof(_bgChangedTiles));
+	_bgDrawn = false;
+
+	rebaseFrameSchedule();
+}
+
+void Screen::clearBackgroundCache() {
+	for (uint i = 0; i < _bgFrames.size(); ++i)
+		delete _bgFrames[i];
+	_bgFrames.clear();
+
+	_bgCacheEnabled = false;
+	_bgCacheComplete = false;
+	_bgHasPalette = false;
 }
 
+/**
+ * Advances the room background when its next frame is due. The first
+ * loop is decoded and, if the background fits in the budget, cached
+ * along with the tiles each frame changes. Later loops are played from
+ * the cache.
+ */
 void Screen::updateBackground() {
-	if (_roomBackgroundFlic.isVideoLoaded()) {
-		if (!_roomBackgroundFlic.isPaused() && _roomBackgroundFlic.getTimeToNextFrame() == 0) {
+	if (!_roomBackgroundFlic.isVideoLoaded() || _roomBackgroundFlic.isPaused())
+		return;
 
-			if (_roomBackgroundFlic.endOfVideo())
-				_roomBackgroundFlic.rewind();
-			_roomBackground = _roomBackgroundFlic.decodeNextFrame();
+	if (_bgCacheComplete) {
+		// A still background never changes once it's decoded
+		if (_bgFrames.size() == 1)
+			return;
 
-			if (_roomBackgroundFlic.hasDirtyPalette()) {
-				const byte *flicPalette = _roomBackgroundFlic.getPalette();
-				memcpy(_palette + 128 * 3, flicPalette + 128 * 3, 128 * 3);
-				_paletteChanged = true;
-			}
+		uint32 now = _system->getMillis();
+
+		if (now < _bgNextFrameTime)
+			return;
+
+		// Don't rush frames to catch up after a pause
+		if (now - _bgNextFrameTime >= _bgFrameDelay)
+			_bgNextFrameTime = now + _bgFrameDelay;
+		else
+			_bgNextFrameTime += _bgFrameDelay;
+
+		_bgFrameIndex = (_bgFrameIndex + 1) % _bgFrames.size();
+
+		const BackgroundFrame *frame = _bgFrames[_bgFrameIndex];
+		_roomBackground = &frame->surface;
+		for (int row = 0; row < DIRTY_TILES_Y; ++row)
+			_bgChangedTiles[row] |= frame->changedTiles[row];
+
+		if (_bgFrameIndex == 0 && _bgHasPalette) {
+			memcpy(_palette + 128 * 3, _bgPalette, 128 * 3);
+			_paletteChanged = true;
+		}
+		return;
+	}
+
+	if (_roomBackgroundFlic.getTimeToNextFrame() != 0)
+		return;
+
+	if (_roomBackgroundFlic.endOfVideo())
+		_roomBackgroundFlic.rewind();
+	_roomBackground = _roomBackgroundFlic.decodeNextFrame();
+
+	uint32 changedTiles[DIRTY_TILES_Y];
+	memset(changedTiles, 0, sizeof(changedTiles));
+
+	const Common::List<Rect> *rects = _roomBackgroundFlic.getDirtyRects();
+	for (Common::List<Rect>::const_iterator rect = rects->begin(); rect != rects->end(); ++rect)
+		markTiles(changedTiles, rect->left, rect->top, rect->right, rect->bottom);
+	_roomBackgroundFlic.clearDirtyRects();
+
+	for (int row = 0; row < DIRTY_TILES_Y; ++row)
+		_bgChangedTiles[row] |= changedTiles[row];
+
+	if (_roomBackgroundFlic.hasDirtyPalette()) {
+		const byte *flicPalette = _roomBackgroundFlic.getPalette();
+		memcpy(_palette + 128 * 3, flicPalette + 128 * 3, 128 * 3);
+		_paletteChanged = true;
+
+		// Only a palette set by the first frame can be replayed
+		if (_bgCacheEnabled && _roomBackgroundFlic.getCurFrame() == 0) {
+			memcpy(_bgPalette, flicPalette + 128 * 3, 128 * 3);
+			_bgHasPalette = true;
+		} else if (_bgCacheEnabled) {
+			clearBackgroundCache();
+		}
+	}
+
+	if (_bgCacheEnabled)
+		cacheBackgroundFrame(changedTiles);
+}
+
+/** Adds the frame just decoded to the background cache */
+void Screen::cacheBackgroundFrame(const uint32 *changedTiles) {
+	uint index = _roomBackgroundFlic.getCurFrame();
+
+	if (index == 0)
+		_bgFirstFrameTime = _roomBackgroundFlic.getTime();
+
+	if (index != _bgFrames.size())
+		return;
+
+	BackgroundFrame *frame = new BackgroundFrame();
+	frame->surface.copyFrom(*_roomBackground);
+	memcpy(frame->changedTiles, changedTiles, sizeof(frame->changedTiles));
+	_bgFrames.push_back(frame);
+
+	if (_bgFrames.size() < _roomBackgroundFlic.getFrameCount())
+		return;
+
+	if (_bgFrames.size() == 1) {
+		_roomBackground = &frame->surface;
+		_bgFrameIndex = 0;
+		_bgCacheComplete = true;
+		return;
+	}
+
+	// The first frame was decoded over nothing. Find what it changes
+	// when the loop wraps around.
+	const Graphics::Surface *first = &_bgFrames[0]->surface;
+	const Graphics::Surface *last = &frame->surface;
+	uint32 *firstTiles = _bgFrames[0]->changedTiles;
+
+	memset(firstTiles, 0, sizeof(_bgFrames[0]->changedTiles));
+	for (int y = 0; y < first->h; ++y) {
+		const byte *a = (const byte *)first->getBasePtr(0, y);
+		const byte *b = (const byte *)last->getBasePtr(0, y);
+
+		for (int col = 0; col * DIRTY_TILE_W < first->w; ++col) {
+			int left = col * DIRTY_TILE_W;
+			int width = MIN<int>(DIRTY_TILE_W, first->w - left);
+
+			if (memcmp(a + left, b + left, width) != 0)
+				firstTiles[y / DIRTY_TILE_H] |= 1u << col;
 		}
 	}
+
+	_bgFrameDelay = MAX<uint32>((_roomBackgroundFlic.getTime() - _bgFirstFrameTime) / (_bgFrames.size() - 1), 1);
+	_bgNextFrameTime = _system->getMillis() + _bgFrameDelay;
+	_bgFrameIndex = _bgFrames.size() - 1;
+	_bgCacheComplete = true;
 }
 
+/**
+ * Copies the background into the room. Only the tiles it changed in and
+ * the tiles drawn over since the last call are copied.
+ */
 void Screen::drawBackground() {
-	if (_roomBackgroundFlic.isVideoLoaded()) {
-		for (uint16 y = 0; y < _roomBackground->h; y++)
-			memcpy(_screenBuf + y * SCREEN_W, (const byte *)_roomBackground->getPixels() + y * _roomBackground->pitch, _roomBackground->w);
+	_talkBackground = 0;
+
+	if (!_roomBackgroundFlic.isVideoLoaded() || !_roomBackground)
+		return;
+
+	const Graphics::Surface *bg = _roomBackground;
+
+	if (!_bgDrawn) {
+		for (uint16 y = 0; y < bg->h; y++)
+			memcpy(_screenBuf + y * SCREEN_W, (const byte *)bg->getPixels() + y * bg->pitch, bg->w);
+
+		markTiles(_dirtyTiles, 0, 0, bg->w, bg->h);
+		_bgDrawn = true;
+
+	} else {
+		for (int row = 0; row < DIRTY_TILES_Y && row * DIRTY_TILE_H < bg->h; ++row) {
+			uint32 bits = _bgChangedTiles[row] | _bgOverdrawnTiles[row];
+			int top = row * DIRTY_TILE_H;
+			int bottom = MIN<int>(top + DIRTY_TILE_H, bg->h);
+
+			for (int col = 0; col < DIRTY_TILES_X; ) {
+				if (!(bits & (1u << col))) {
+					col++;
+					continue;
+				}
+
+				int start = col;
+				while (col < DIRTY_TILES_X && (bits & (1u << col)))
+					col++;
+
+				int left = start * DIRTY_TILE_W;
+				int right = MIN<int>(col * DIRTY_TILE_W, bg->w);
+
+				for (int y = top; y < bottom && left < right; y++)
+					memcpy(_screenBuf + y * SCREEN_W + left, (const byte *)bg->getBasePtr(left, y), right - left);
+			}
+
+			_dirtyTiles[row] |= bits;
+		}
 	}
+
+	memset(_bgChangedTiles, 0, sizeof(_bgChangedTiles));
+	memset(_bgOverdrawnTiles, 0, sizeof(_bgOverdrawnTiles));
 }
 
-void Screen::drawTalkFrame(const Graphics::Surface *frame, const byte *background) {
-	memcpy(_screenBuf, background, SCREEN_W * ROOM_H);
-	for (int i = 0; i < SCREEN_W * ROOM_H; i++) {
-		byte color = ((const byte *)frame->getPixels())[i];
-		if (color != 0)
-			_screenBuf[i] = color;
+/**
+ * Draws a talk video frame over its background. bounds covers the
+ * frame's non-transparent pixels. When the previous talk frame was drawn
+ * over the same background and nothing else has drawn over the room
+ * since, only the bounds of both frames are redrawn.
+ */
+void Screen::drawTalkFrame(const Graphics::Surface *frame, const byte *background, const Common::Rect &bounds) {
+	Rect area(0, 0, SCREEN_W, ROOM_H);
+
+	if (_talkBackground == background) {
+		area = bounds;
+		if (area.isEmpty())
+			area = _talkBounds;
+		else if (!_talkBounds.isEmpty())
+			area.extend(_talkBounds);
+		area.clip(Rect(0, 0, SCREEN_W, ROOM_H));
 	}
-	_fullRedraw = true;
+
+	for (int y = area.top; y < area.bottom; y++) {
+		byte *dst = _screenBuf + y * SCREEN_W;
+
+		memcpy(dst + area.left, background + y * SCREEN_W + area.left, area.width());
+
+		if (y >= frame->h)
+			continue;
+
+		const byte *src = (const byte *)frame->getBasePtr(0, y);
+		for (int x = area.left; x < MIN<int>(area.right, frame->w); x++)
+			if (src[x] != 0)
+				dst[x] = src[x];
+	}
+
+	// Not through markDirty(), which would forget the talk frame
+	markTiles(_dirtyTiles, area.left, area.top, area.right, area.bottom);
+	markTiles(_bgOverdrawnTiles, area.left, area.top, area.right, area.bottom);
+
+	_talkBackground = background;
+	_talkBounds = bounds;
 }
 
 void Screen::loadMask(const Path &filename) {
 	_roomMaskFlic.loadFile(filename);
 	_roomMask = 0;
 	_roomMask = _roomMaskFlic.decodeNextFrame();
+
+	// Split each line into runs of equal depth, so that actor draws can
+	// handle whole runs, or whole lines, at once
+	_maskRuns.clear();
+
+	for (int y = 0; y < ROOM_H; ++y) {
+		const byte *row = NULL;
+
+		if (_roomMask && y < _roomMask->h)
+			row = (const byte *)_roomMask->getPixels() + y * SCREEN_W;
+
+		_maskRowRuns[y] = _maskRuns.size();
+		_maskRowMin[y] = 255;
+		_maskRowMax[y] = 0;
+
+		for (int x = 0; x < SCREEN_W; ) {
+			MaskRun run;
+			run.x = x;
+			run.depth = row ? row[x] : 255;
+
+			while (x < SCREEN_W && (row ? row[x] : 255) == run.depth)
+				x++;
+
+			_maskRuns.push_back(run);
+			_maskRowMin[y] = MIN(_maskRowMin[y], run.depth);
+			_maskRowMax[y] = MAX(_maskRowMax[y], run.depth);
+		}
+	}
+	_maskRowRuns[ROOM_H] = _maskRuns.size();
 }
 
 void Screen::drawInventory(Inventory *inv) {
@@ -1963,7 +2546,7 @@ uint16 Screen::getTextWidth(const char *text) {
 			w += 12;
 			break;*/
 		default:
-			w += *((const uint8 *)(_font->getCharData(text[i])));
+			w += _font->getCharWidth(text[i]);
 		}
 		++w;
 	}
@@ -1982,110 +2565,114 @@ void Screen::displayDoors() {
 	}
 }
 
-void Screen::narratorScrollInit(char *text) {
+/**
+ * Lays out the narrator text into a strip of lines 10 pixels apart, the
+ * first one at row 20. The strip scrolls up a line at a time until the
+ * last line is at the top, at a speed that gives each line an equal share
+ * of the speech, which lasts duration milliseconds.
+ */
+void Screen::narratorScrollInit(char *text, uint32 duration) {
+	Common::Array<const char *> words;
+	Common::Array<uint16> wordLines;
+	Common::Array<uint16> wordCols;
+	uint16 lines = 0;
+	int col = 6;
+
 	_narratorScrollText = text;
-	_narratorTextSurface = new byte[SCREEN_W * 40];
-	memset(_narratorTextSurface, 0, SCREEN_W * 40);
-	_narratorScrollStatus = 1;
 
-	_narratorWord = strtok(_narratorScrollText, " ");
+	for (char *word = strtok(_narratorScrollText, " "); word != 0; word = strtok(NULL, " ")) {
+		// Calculate the width + space char
+		int width = getTextWidth(word) + 4 + 1;
+
+		if (lines == 0 || (col + width > 308 && col > 6)) {
+			lines++;
+			col = 6;
+		}
+
+		words.push_back(word);
+		wordLines.push_back(lines - 1);
+		wordCols.push_back(col);
+		col += width;
+	}
+
+	ActorFrame *strip = new ActorFrame();
+	strip->width = SCREEN_W;
+	strip->height = 10 * lines + 30;
+	strip->pixels = new byte[strip->width * strip->height];
+	strip->rowSpans = new uint32[strip->height + 1];
+	memset(strip->pixels, 0, strip->width * strip->height);
+
+	for (uint i = 0; i < words.size(); ++i) {
+		char word[140];
+
+		Common::strlcpy(word, words[i], sizeof(word));
+		Common::strlcat(word, " ", sizeof(word));
+
+		// Each line is written 6 pixels to the right of its columns
+		writeText(strip->pixels + (20 + 10 * wordLines[i]) * SCREEN_W + 6, word, 0, wordCols[i], 25, true);
+	}
+
+	strip->findSpans();
+	_narratorStrip = strip;
+
+	_narratorScrollPos = 0;
+	_narratorScrollEnd = 10 * MAX<int>(lines - 1, 0);
+	_narratorScrollTimer = 0;
+
+	// 256 is one pixel. Reach the last line when it has its share left.
+	uint32 frames = duration * FRAME_RATE / 1000;
+	if (frames > 0)
+		_narratorScrollSpeed = (10 * 256 * lines + frames - 1) / frames;
+	else
+		_narratorScrollSpeed = 40;
 }
 
 void Screen::narratorScrollUpdate() {
-	static int scrollSpeed, scrollTimer, scrollPos;
-
 	if (!_vm->game()->isNarratorPlaying()) {
 		// TODO - hack
 		return;
 	}
 
 	// TODO - another hack
-	if (_narratorScrollText == 0)
+	if (_narratorStrip == 0)
 		return;
 
-	switch (_narratorScrollStatus) {
-	case 1:
-		scrollSpeed = 40;
-		scrollTimer = 0;
-		scrollPos = 0;
-		_narratorScrollStatus = 2;
-		narratorWriteLine(_narratorTextSurface + 20 * SCREEN_W);
-		break;
-	case 2:
-		if (_narratorWord == 0) {
-			_narratorScrollStatus = 5;
-		} else {
-			narratorWriteLine(_narratorTextSurface + 30 * SCREEN_W);
-			_narratorScrollStatus = 3;
-		}
-		break;
-	case 3:
-		scrollTimer += scrollSpeed;
+	if (_narratorScrollPos < _narratorScrollEnd) {
+		_narratorScrollTimer += _narratorScrollSpeed;
 
 		// Left click speeds up the scrolling
 		// FIXME: doesn't work beyond one frame due to resetInput
 		if (_vm->input()->getLeftClick())
-			scrollTimer += 2 * scrollSpeed;
-
-		if (scrollTimer >= 256) {
-			scrollTimer -= 256;
-			scrollPos++;
-			if (scrollPos == 10) {
-				scrollPos = 0;
-				memmove(_narratorTextSurface, _narratorTextSurface + 10 * SCREEN_W, 30 * SCREEN_W);
-				memset(_narratorTextSurface + 30 * SCREEN_W, 0, 10 * SCREEN_W);
-				_narratorScrollStatus = 2;
-			}
-		}
-		break;
+			_narratorScrollTimer += 2 * _narratorScrollSpeed;
+
+		_narratorScrollPos = MIN(_narratorScrollPos + _narratorScrollTimer / 256, _narratorScrollEnd);
+		_narratorScrollTimer %= 256;
 	}
 
 	drawPanel(_vm->panel()->getPanelBackground());
 
-	byte *from = _narratorTextSurface + (scrollPos + 3) * SCREEN_W;
-	byte *to = _screenBuf + 172 * SCREEN_W;
-	for (int i = 0; i < 27 * SCREEN_W; ++i) {
-		if (from[i] != 0)
-			to[i] = from[i];
+	// Show 27 rows of the strip at the bottom of the panel
+	for (int i = 0; i < 27; ++i) {
+		int line = _narratorScrollPos + 3 + i;
+		const byte *from = _narratorStrip->getRow(line);
+		byte *to = _screenBuf + (172 + i) * SCREEN_W;
+
+		for (uint32 s = _narratorStrip->rowSpans[line]; s < _narratorStrip->rowSpans[line + 1]; s += 2)
+			memcpy(to + _narratorStrip->spans[s], from + _narratorStrip->spans[s], _narratorStrip->spans[s + 1]);
 	}
 }
 
 void Screen::narratorScrollDelete() {
 	delete[] _narratorScrollText;
 	_narratorScrollText = 0;
-	delete[] _narratorTextSurface;
-	_narratorTextSurface = 0;
-	_narratorScrollStatus = 0;
-}
-
-void Screen::narratorWriteLine(byte *buf) {
-	int width;
-	int col = 6;
-	char word[140];
-
-	buf += col;
-
-	while (_narratorWord) {
-		// Calculate the width + space char
-		width = getTextWidth(_narratorWord) + 4 + 1;
-
-		if (col + width > 308)
-			return;
-
-		Common::strlcpy(word, _narratorWord, sizeof(word));
-		Common::strlcat(word, " ", sizeof(word));
-
-		writeText(buf, word, 0, col, 25, true);
-		col += width;
-
-		_narratorWord = strtok(NULL, " ");
-	}
+	delete _narratorStrip;
+	_narratorStrip = 0;
 }
 
 uint16 Screen::calcWordWidth(const char *word) {
 	uint8 width = 0;
 	for (int i = 0; word[i] != '\0'; ++i)
-		width += *(const uint8 *)_font->getCharData(word[i]) + 1;
+		width += _font->getCharWidth(word[i]) + 1;
 	return width + 4; // +4 for space char
 }
 
@@ -2123,15 +2710,14 @@ void Screen::writeText(byte *buf, const char *text, uint8 row, uint16 col, uint8
 	// Report dirty rect if above panel area
 	if (buf == _screenBuf && row < ROOM_H) {
 		if (isEmbossed)
-			_dirtyRects->push_back(Rect(col - 1, row - 1, col + getTextWidth(text) + 1, row + 8 + 1));
+			markDirty(col - 1, row - 1, col + getTextWidth(text) + 1, row + 8 + 1);
 		else
-			_dirtyRects->push_back(Rect(col, row, col + getTextWidth(text), row + 8));
+			markDirty(col, row, col + getTextWidth(text), row + 8);
 	}
 }
 void Screen::writeTextStyle(byte *buf, const char *text, uint8 startRow, uint16 startCol, uint8 color, bool isBackground) {
 	uint16 col = startCol;
-	uint8 charWidth;
-	const byte *data;
+	const Glyph *glyph;
 
 	// The "Nunchukas" description string in room 64 overflows over the right edge of the screen.
 	// This happens in the original as well.
@@ -2145,28 +2731,30 @@ void Screen::writeTextStyle(byte *buf, const char *text, uint8 startRow, uint16
 			col += 12;
 			break;
 		default:
-			data = _font->getCharData(text[i]);
-			charWidth = (uint8)*data;
-			++data;
-
-			for (uint w = 0; w < charWidth; ++w) {
-				for (uint8 h = 0; h < 8; ++h) {
-					if (*data != 0) {
-						if (isBackground) {
-							*(buf + SCREEN_W * (startRow + h) + col + w - 1) = 3;
-							*(buf + SCREEN_W * (startRow + h - 1) + col + w) = 3;
-							*(buf + SCREEN_W * (startRow + h - 1) + col + w - 1) = 3;
-							*(buf + SCREEN_W * (startRow + h) + col + w + 1) = 53;
-							*(buf + SCREEN_W * (startRow + h + 1) + col + w) = 53;
-							*(buf + SCREEN_W * (startRow + h + 1) + col + w + 1) = 53;
-						} else {
-							*(buf + SCREEN_W * (startRow + h) + col + w) = color;
-						}
-					}
-					++data;
+			glyph = _font->getGlyph(text[i]);
+
+			if (isBackground) {
+				int pitch = glyph->width + 2;
+				byte *dst = buf + SCREEN_W * (startRow - 1) + col - 1;
+
+				for (int h = 0; h < 10; ++h, dst += SCREEN_W) {
+					const byte *src = glyph->emboss + h * pitch;
+					for (int w = 0; w < pitch; ++w)
+						if (src[w] != 0)
+							dst[w] = src[w];
+				}
+			} else {
+				byte *dst = buf + SCREEN_W * startRow + col;
+
+				for (int h = 0; h < 8; ++h, dst += SCREEN_W) {
+					const byte *src = glyph->mask + h * glyph->width;
+					for (int w = 0; w < glyph->width; ++w)
+						if (src[w] != 0)
+							dst[w] = color;
 				}
 			}
-			col += charWidth;
+
+			col += glyph->width;
 		}
 
 		col += 1;
@@ -2175,7 +2763,7 @@ void Screen::writeTextStyle(byte *buf, const char *text, uint8 startRow, uint16
 
 void Screen::drawBoxScreen(int x, int y, int width, int height, byte color) {
 	drawBox(_screenBuf, x, y, width, height, color);
-	_dirtyRects->push_back(Rect(x, y, x + width, y + height));
+	markDirty(x, y, x + width, y + height);
 }
 
 void Screen::drawBox(byte *surface, int x, int y, int width, int height, byte color) {
@@ -25,6 +25,10 @@
 
 #include "common/scummsys.h"
 #include "common/str.h"
+#include "common/array.h"
+#include "common/list.h"
+#include "common/hashmap.h"
+#include "common/rect.h"
 
 #include "kom/video_player.h"
 
@@ -32,8 +36,6 @@ class OSystem;
 
 namespace Common {
 struct Path;
-struct Rect;
-template<typename t_T> class List;
 }
 
 namespace Graphics {
@@ -44,6 +46,9 @@ namespace Kom {
 
 class Font;
 class KomEngine;
+struct ActorFrame;
+struct BackgroundFrame;
+struct ScaledFrame;
 struct Inventory;
 
 enum {
@@ -56,6 +61,17 @@ enum {
 	INVENTORY_OFFSET = 344
 };
 
+enum {
+	FRAME_RATE = 24
+};
+
+enum {
+	DIRTY_TILE_W = 16,
+	DIRTY_TILE_H = 8,
+	DIRTY_TILES_X = SCREEN_W / DIRTY_TILE_W,
+	DIRTY_TILES_Y = SCREEN_H / DIRTY_TILE_H
+};
+
 struct ColorSet {
 	ColorSet(const Common::Path &filename);
 	ColorSet(const char *filename): ColorSet(Common::Path(filename)) {}
@@ -65,6 +81,59 @@ struct ColorSet {
 	byte *data;
 };
 
+enum {
+	kScaleTableCacheSize = 32,
+	kBackgroundCacheBudget = 2 * 1024 * 1024,
+	kScaledFrameCacheBudget = 512 * 1024
+};
+
+/**
+ * Source pixel index for each pixel of a scaled line, see
+ * Screen::getScaleTable()
+ */
+struct ScaleTable {
+	uint16 srcSize;
+	uint16 scaledSize;
+	uint16 clip;
+	uint8 index[SCREEN_W];
+	uint16 next[SCREEN_W]; // The aura border's look-ahead to the right
+};
+
+/** Key of the scaled frame cache, see Screen::getScaledFrame() */
+struct ScaledFrameKey {
+	ScaledFrameKey() : frame(0), width(0), height(0) {}
+	ScaledFrameKey(const ActorFrame *f, int16 w, int16 h) : frame(f), width(w), height(h) {}
+
+	bool operator==(const ScaledFrameKey &other) const {
+		return frame == other.frame && width == other.width && height == other.height;
+	}
+
+	const ActorFrame *frame;
+	int16 width;
+	int16 height;
+};
+
+struct ScaledFrameKeyHash {
+	uint operator()(const ScaledFrameKey &key) const {
+		return (uint)((uintptr)key.frame >> 3) * 31 + (uint)key.width * 65599 + (uint)key.height;
+	}
+};
+
+/** A run of equal depth in a line of the room mask, up to the next run */
+struct MaskRun {
+	uint16 x;
+	uint8 depth;
+};
+
+/** Frame pacing statistics, see Screen::gfxUpdate() */
+struct FrameStats {
+	uint32 frames;
+	uint32 lateFrames;  // Frames that were ready after their deadline
+	uint32 totalWork;   // Time spent on frames, not counting the wait
+	uint32 maxWork;
+	uint32 maxLateness;
+};
+
 class Screen {
 public:
 
@@ -77,15 +146,22 @@ public:
 
 	void processGraphics(int mode, bool samplePlaying = false);
 	void drawDirtyRects();
+	void markDirty(int left, int top, int right, int bottom);
+	void forceFullRedraw();
 	void gfxUpdate();
+	const FrameStats &frameStats() const { return _frameStats; }
+	void resetFrameStats();
+	void rebaseFrameSchedule();
 	void clearScreen(bool now = false);
 	void clearRoom();
-	void drawActorFrameScaled(const int8 *data, uint16 width, uint16 height, int16 xStart, int16 yStart,
+	void purgeScaledFrames(const ActorFrame *frame);
+	void drawActorFrameScaled(const ActorFrame *frame, int16 xStart, int16 yStart,
 			int16 xEnd, int16 yEnd, int maskDepth, bool invisible = false);
-	void drawActorFrameScaledAura(const int8 *data, uint16 width, uint16 height, int16 xStart, int16 yStart,
+	void drawActorFrameScaledAura(const ActorFrame *frame, int16 xStart, int16 yStart,
 			int16 xEnd, int16 yEnd, int maskDepth);
-	void drawActorFrame(const int8 *data, uint16 width, uint16 height, int16 xStart, int16 yStart, bool greyedOut = false);
-	void drawMouseFrame(const int8 *data, uint16 width, uint16 height, int16 xOffset, int16 yOffset);
+	void drawActorFrame(const ActorFrame *frame, int16 xStart, int16 yStart, bool greyedOut = false);
+	const byte *cacheCursor(int16 frameId, const ActorFrame *frame);
+	void drawMouseFrame(int16 frameId, const ActorFrame *frame, int16 xOffset, int16 yOffset);
 
 	void setMouseCursor(const byte *buf, uint w, uint h, int hotspotX, int hotspotY);
 	void showMouseCursor(bool show);
@@ -93,6 +169,8 @@ public:
 	bool isCursorVisible();
 
 	void drawPanel(const byte *panelData);
+	void drawPanelRows(const byte *panelData, int top, int bottom);
+	bool isPanelOverdrawn() const { return _panelOverdrawTop < _panelOverdrawBottom; }
 	void clearPanel();
 	void updatePanelOnScreen(bool clearScreenFlag);
 
@@ -100,7 +178,7 @@ public:
 	void updateBackground();
 	void drawBackground();
 	void pauseBackground(bool pause) { _roomBackgroundFlic.pauseVideo(pause); }
-	void drawTalkFrame(const Graphics::Surface *frame, const byte *background);
+	void drawTalkFrame(const Graphics::Surface *frame, const byte *background, const Common::Rect &bounds);
 	void copyBackground(const Graphics::Surface *surface);
 	void loadMask(const Common::Path &filename);
 
@@ -118,12 +196,14 @@ public:
 
 	void setBrightness(uint16 brightness) { _newBrightness = brightness; }
 
+	/** Call after setting the backend palette directly */
+	void invalidateShownPalette() { _shownPaletteValid = false; }
+
 	void displayDoors();
 
-	void narratorScrollInit(char *text);
+	void narratorScrollInit(char *text, uint32 duration);
 	void narratorScrollUpdate();
 	void narratorScrollDelete();
-	void narratorWriteLine(byte *buf);
 
 	uint16 calcWordWidth(const char *word);
 
@@ -145,14 +225,22 @@ public:
 
 private:
 
-	void copyRectListToScreen(const Common::List<Common::Rect> *);
+	void copyTilesToScreen(const uint32 *tiles);
+	void copyTileRectToScreen(int left, int top, int right, int bottom);
+	void cacheBackgroundFrame(const uint32 *changedTiles);
+	void clearBackgroundCache();
 
-	void drawActorFrameLine(byte *outBuffer, const int8 *rowData, uint16 length);
+	void blendLineOverMask(byte *target, const byte *src, const byte *values,
+			int line, int xStart, int count, int maskDepth);
+	const ScaleTable *getScaleTable(ScaleTable *cache, uint16 srcSize, uint16 scaledSize, uint16 clip);
+	const ScaledFrame *getScaledFrame(const ActorFrame *frame, int16 width, int16 height);
 
 	void writeTextStyle(byte *buf, const char *text, uint8 startRow, uint16 startCol, uint8 color, bool isBackground);
 
 	void doFadeTo();
 	void updatePaletteWithBrightness();
+	void setSystemPalette(const byte *colors, uint start, uint num);
+	void pushPalette(const byte *palette);
 
 	void printIcon(Inventory *inv, int objNum, int mode);
 
@@ -162,15 +250,34 @@ private:
 	KomEngine *_vm;
 
 	uint8 *_screenBuf;
-	uint8 *_mouseBuf;
+
+	// Cursor bitmaps of the mouse actor frames, and the one last set
+	Common::Array<byte *> _cursors;
+	int16 _cursorFrame;
+	int16 _cursorX;
+	int16 _cursorY;
+
 	FlicDecoder _roomBackgroundFlic;
 	FlicDecoder _roomMaskFlic;
 	const Graphics::Surface *_roomBackground;
 	const Graphics::Surface *_roomMask;
+	Common::Array<MaskRun> _maskRuns;
+	uint32 _maskRowRuns[ROOM_H + 1];
+	uint8 _maskRowMin[ROOM_H];
+	uint8 _maskRowMax[ROOM_H];
 	Font *_font;
 
 	bool _fullRedraw;
 
+	// Panel rows drawn over by anything but drawPanelRows(), which
+	// restores them
+	int16 _panelOverdrawTop;
+	int16 _panelOverdrawBottom;
+
+	// The last talk frame's background and bounds, see drawTalkFrame()
+	const byte *_talkBackground;
+	Common::Rect _talkBounds;
+
 	byte *_sepiaScreen;
 	byte _sepiaBackupPalette[256 * 3];
 
@@ -180,6 +287,10 @@ private:
 	byte _palette[256 * 3];
 	bool _paletteChanged;
 
+	// What the backend was last given, see pushPalette()
+	byte _shownPalette[256 * 3];
+	bool _shownPaletteValid;
+
 	uint16 _currBrightness;
 	uint16 _newBrightness;
 	bool _isFading;
@@ -188,14 +299,47 @@ private:
 	uint16 _fadeSpeed;
 
 	uint32 _lastFrameTime;
-
-	Common::List<Common::Rect> *_dirtyRects;
-	Common::List<Common::Rect> *_prevDirtyRects;
+	uint32 _frameBase;
+	uint32 _frameNum;
+	bool _skipFrameStats; // The next frame follows a blocking operation
+	FrameStats _frameStats;
+
+	// One bit per tile, for the current and the previous frame
+	uint32 _dirtyTiles[DIRTY_TILES_Y];
+	uint32 _prevDirtyTiles[DIRTY_TILES_Y];
+
+	// Tiles drawBackground() has to restore: changed in the background,
+	// and drawn over in the room since it was last drawn
+	uint32 _bgChangedTiles[DIRTY_TILES_Y];
+	uint32 _bgOverdrawnTiles[DIRTY_TILES_Y];
+	bool _bgDrawn;
+
+	// Decoded frames of a still or looping room background that fits in
+	// kBackgroundCacheBudget. Once all are cached, the decoder is idle.
+	Common::Array<BackgroundFrame *> _bgFrames;
+	bool _bgCacheEnabled;
+	bool _bgCacheComplete;
+	uint _bgFrameIndex;
+	uint32 _bgFrameDelay;
+	uint32 _bgFirstFrameTime;
+	uint32 _bgNextFrameTime;
+	byte _bgPalette[128 * 3]; // Set by the first frame, if _bgHasPalette
+	bool _bgHasPalette;
+
+	ScaleTable _colScaleTables[kScaleTableCacheSize];
+	ScaleTable _lineScaleTables[kScaleTableCacheSize];
+
+	// Most recently used first, for eviction, and indexed for lookup
+	Common::List<ScaledFrame *> _scaledFrames;
+	Common::HashMap<ScaledFrameKey, Common::List<ScaledFrame *>::iterator, ScaledFrameKeyHash> _scaledFrameIndex;
+	uint32 _scaledFramesSize;
 
 	char *_narratorScrollText;
-	char *_narratorWord;
-	byte *_narratorTextSurface;
-	uint8 _narratorScrollStatus;
+	ActorFrame *_narratorStrip;
+	int _narratorScrollPos;
+	int _narratorScrollEnd;
+	int _narratorScrollSpeed;
+	int _narratorScrollTimer;
 };
 
 } // End of namespace Kom
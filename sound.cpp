@@ -160,6 +160,7 @@ bool SoundSample::loadFile(const Path &filename, bool isSpeech) {
 void SoundSample::unload() {
 	delete _stream;
 	_stream = NULL;
+	_length = 0;
 	if (_isSpeech) {
 		delete[] _sampleData;
 	   _sampleData = NULL;
@@ -180,6 +181,7 @@ void SoundSample::loadCompressed(Common::File &f, int offset, int size) {
 		f.read(data, size);
 		_stream = Audio::makeRawStream(data, size,
 				11025, Audio::FLAG_UNSIGNED);
+		_length = size;
 
 	// Compressed
 	} else {
@@ -195,6 +197,7 @@ void SoundSample::loadCompressed(Common::File &f, int offset, int size) {
 				11025,
 				1);
 
+		_length = size * 2;
 		_isCompressed = true;
 	}
 }
@@ -45,7 +45,7 @@ typedef Audio::SoundHandle SoundHandle;
 class SoundSample {
 	friend class Sound;
 public:
-	SoundSample() { _stream = 0; _isCompressed = false; _isSpeech = false; _sampleData = 0; }
+	SoundSample() { _stream = 0; _isCompressed = false; _isSpeech = false; _sampleData = 0; _length = 0; }
 	~SoundSample() { unload(); }
 
 	bool loadFile(const Common::Path &filename, bool isSpeech = false);
@@ -53,6 +53,7 @@ public:
 	bool isLoaded() { return _stream != 0; }
 	int16 const *getSamples();
 	uint getSampleCount();
+	uint32 getDuration() const { return _length * 1000 / 11025; }
 
 private:
 	Audio::SoundHandle _handle;
@@ -61,6 +62,7 @@ private:
 	bool _isCompressed;
 	int16 *_sampleData;
 	int _sampleCount;
+	uint32 _length; // In samples at 11025 Hz
 
 	void loadCompressed(Common::File &f, int offset, int size);
 };
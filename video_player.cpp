@@ -42,7 +42,7 @@ using Common::Path;
 namespace Kom {
 
 VideoPlayer::VideoPlayer(KomEngine *vm) : _vm(vm),
-	_smk(), _background(0) {
+	_smk(), _background(0), _composite(0) {
 	_eventMan = _vm->_system->getEventManager();
 }
 
@@ -103,6 +103,7 @@ bool VideoPlayer::playVideo(const Path &filename) {
 		_vm->sound()->playFileSFX(filenameWithoutExt.append("raw"), &_soundHandle);
 
 		_background = _vm->screen()->createZoomBlur(160, 100);
+		_composite = new byte[SCREEN_W * ROOM_H];
 	}
 
 	_vm->_system->fillScreen(0);
@@ -123,10 +124,14 @@ bool VideoPlayer::playVideo(const Path &filename) {
 	if (_background) {
 		delete[] _background;
 		_background = 0;
+		delete[] _composite;
+		_composite = 0;
 	}
 
 	_vm->_system->fillScreen(0);
 	_vm->_system->updateScreen();
+	_vm->screen()->forceFullRedraw();
+	_vm->screen()->rebaseFrameSchedule();
 
 	// Restore the palette
 	_vm->screen()->restorePalette(backupPalette);
@@ -144,27 +149,32 @@ void VideoPlayer::processFrame() {
 		return;
 	}
 
-	Graphics::Surface *screen = _vm->_system->lockScreen();
-
 	if (_player->hasDirtyPalette() && _player == &_smk) {
 		_vm->_system->getPaletteManager()->setPalette(_smk.getPalette(), 0, 256);
+		_vm->screen()->invalidateShownPalette();
 	}
 
 	if (!_background) {
+		Graphics::Surface *screen = _vm->_system->lockScreen();
+
 		for (uint16 y = 0; y < frame->h; y++)
 			memcpy((byte *)screen->getPixels() + y * screen->pitch, (const byte *)frame->getPixels() + y * frame->pitch, frame->w);
 
+		_vm->_system->unlockScreen();
+
 	} else {
-		memcpy((byte *)screen->getPixels(), _background, SCREEN_W * ROOM_H);
-		for (int i = 0; i < SCREEN_W * ROOM_H; i++) {
-			byte color = ((const byte *)frame->getPixels())[i];
-			if (color != 0)
-				((byte *)screen->getPixels())[i] = color;
+		// Only the first frame needs to be composed in full, after that
+		// the flic decoder reports what changed
+		if (_player->getCurFrame() == 0) {
+			composeRect(frame, Common::Rect(0, 0, SCREEN_W, ROOM_H));
+		} else {
+			const Common::List<Common::Rect> *rects = _flic.getDirtyRects();
+			for (Common::List<Common::Rect>::const_iterator rect = rects->begin(); rect != rects->end(); ++rect)
+				composeRect(frame, *rect);
 		}
+		_flic.clearDirtyRects();
 	}
 
-	_vm->_system->unlockScreen();
-
 	// Update the screen
 	_vm->_system->updateScreen();
 
@@ -172,15 +182,105 @@ void VideoPlayer::processFrame() {
 	_vm->_system->delayMillis(_player->getTimeToNextFrame());
 }
 
+/** Draws the frame over the background within rect, and sends it to the screen */
+void VideoPlayer::composeRect(const Graphics::Surface *frame, Common::Rect rect) {
+	rect.clip(Common::Rect(0, 0, SCREEN_W, ROOM_H));
+	if (rect.isEmpty())
+		return;
+
+	for (int y = rect.top; y < rect.bottom; y++) {
+		byte *dst = _composite + y * SCREEN_W + rect.left;
+
+		memcpy(dst, _background + y * SCREEN_W + rect.left, rect.width());
+
+		if (y >= frame->h)
+			continue;
+
+		const byte *src = (const byte *)frame->getBasePtr(0, y);
+		for (int x = rect.left; x < MIN<int>(rect.right, frame->w); x++)
+			if (src[x] != 0)
+				dst[x - rect.left] = src[x];
+	}
+
+	_vm->_system->copyRectToScreen(_composite + rect.top * SCREEN_W + rect.left, SCREEN_W,
+		rect.left, rect.top, rect.width(), rect.height());
+}
+
+static Common::Rect getOpaqueBounds(const Graphics::Surface *surface) {
+	int left = surface->w, top = surface->h, right = 0, bottom = 0;
+
+	for (int y = 0; y < surface->h; y++) {
+		const byte *row = (const byte *)surface->getBasePtr(0, y);
+
+		for (int x = 0; x < surface->w; x++) {
+			if (row[x] != 0) {
+				left = MIN(left, x);
+				right = MAX(right, x + 1);
+				top = MIN(top, y);
+				bottom = y + 1;
+			}
+		}
+	}
+
+	if (left >= right)
+		return Common::Rect();
+	return Common::Rect(left, top, right, bottom);
+}
+
 void VideoPlayer::loadTalkVideo(const Path &filename, byte *background) {
 	if (!_flic.loadFile(filename))
 		error("Could not load video file: %s\n", filename.toString().c_str());
 	_flic.start();
 	_background = background;
+
+	clearTalkFrames();
+	_talkFrames.resize(_flic.getFrameCount());
+	_talkFrameBounds.resize(_flic.getFrameCount());
+	_talkFrameBoundsKnown.resize(_flic.getFrameCount());
+	for (uint i = 0; i < _talkFrames.size(); ++i) {
+		_talkFrames[i] = NULL;
+		_talkFrameBoundsKnown[i] = false;
+	}
+}
+
+void VideoPlayer::clearTalkFrames() {
+	for (uint i = 0; i < _talkFrames.size(); ++i) {
+		if (_talkFrames[i]) {
+			_talkFrames[i]->free();
+			delete _talkFrames[i];
+		}
+	}
+	_talkFrames.clear();
+	_talkFrameBounds.clear();
+	_talkFrameBoundsKnown.clear();
+}
+
+/**
+ * Returns the bounds of the non-transparent pixels of a talk frame. Each
+ * frame is only scanned the first time it's drawn.
+ */
+Common::Rect VideoPlayer::getTalkFrameBounds(uint index, const Graphics::Surface *surface) {
+	if (index >= _talkFrameBounds.size())
+		return getOpaqueBounds(surface);
+
+	if (!_talkFrameBoundsKnown[index]) {
+		_talkFrameBounds[index] = getOpaqueBounds(surface);
+		_talkFrameBoundsKnown[index] = true;
+	}
+
+	return _talkFrameBounds[index];
 }
 
 void VideoPlayer::drawTalkFrame(int frame) {
 	const Graphics::Surface *surface = NULL;
+	uint index = frame - 1;
+
+	// Lip sync jumps back and forth between frames, so keep every frame
+	// decoded on the way rather than decoding from the start each time
+	if (index < _talkFrames.size() && _talkFrames[index]) {
+		_vm->screen()->drawTalkFrame(_talkFrames[index], _background, _talkFrameBounds[index]);
+		return;
+	}
 
 	if (_flic.getCurFrame() + 1 >= frame) {
 		_flic.rewind();
@@ -189,9 +289,19 @@ void VideoPlayer::drawTalkFrame(int frame) {
 	// Seek to frame
 	while (_flic.getCurFrame() + 1 != frame) {
 		surface = _flic.decodeNextFrame();
+
+		uint decoded = _flic.getCurFrame();
+		if (surface && decoded < _talkFrames.size() && !_talkFrames[decoded]) {
+			_talkFrames[decoded] = new Graphics::Surface();
+			_talkFrames[decoded]->copyFrom(*surface);
+			getTalkFrameBounds(decoded, surface);
+		}
 	}
 
-	_vm->screen()->drawTalkFrame(surface, _background);
+	if (index < _talkFrames.size() && _talkFrames[index])
+		_vm->screen()->drawTalkFrame(_talkFrames[index], _background, _talkFrameBounds[index]);
+	else
+		_vm->screen()->drawTalkFrame(surface, _background, getTalkFrameBounds(index, surface));
 }
 
 void VideoPlayer::drawTalkFrameCycle() {
@@ -199,7 +309,7 @@ void VideoPlayer::drawTalkFrameCycle() {
 		_flic.rewind();
 
 	const Graphics::Surface *surface = _flic.decodeNextFrame();
-	_vm->screen()->drawTalkFrame(surface, _background);
+	_vm->screen()->drawTalkFrame(surface, _background, getTalkFrameBounds(_flic.getCurFrame(), surface));
 }
 
 } // End of namespace Kom
@@ -23,6 +23,9 @@
 #ifndef KOM_VIDEO_PLAYER_H
 #define KOM_VIDEO_PLAYER_H
 
+#include "common/array.h"
+#include "common/rect.h"
+
 #include "video/video_decoder.h"
 #include "video/smk_decoder.h"
 #include "video/flic_decoder.h"
@@ -41,7 +44,7 @@ class FlicDecoder : public Video::FlicDecoder {
 class VideoPlayer {
 public:
 	VideoPlayer(KomEngine *vm);
-	~VideoPlayer() { }
+	~VideoPlayer() { clearTalkFrames(); }
 
 	bool playVideo(const Common::Path &filename);
 
@@ -51,6 +54,9 @@ public:
 private:
 	void processFrame();
 	void processEvents();
+	void composeRect(const Graphics::Surface *frame, Common::Rect rect);
+	void clearTalkFrames();
+	Common::Rect getTalkFrameBounds(uint index, const Graphics::Surface *surface);
 	bool _skipVideo;
 	KomEngine *_vm;
 	Common::EventManager *_eventMan;
@@ -58,7 +64,15 @@ private:
 	FlicDecoder _flic;
 	Video::VideoDecoder *_player;
 	byte *_background;
+	byte *_composite;
 	SoundHandle _soundHandle;
+
+	// Talk video frames already decoded by drawTalkFrame(), by frame index.
+	// The bounds of their non-transparent pixels are kept for every frame
+	// drawn, including the uncached cycling ones.
+	Common::Array<Graphics::Surface *> _talkFrames;
+	Common::Array<Common::Rect> _talkFrameBounds;
+	Common::Array<bool> _talkFrameBoundsKnown;
 };
 
 } // End of namespace Kom